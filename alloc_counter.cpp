@@ -0,0 +1,45 @@
+#include "alloc_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace geom {
+
+static thread_local size_t allocationCount = 0;
+
+bool allocationsCounted() {
+    return true;
+}
+
+size_t threadAllocations() {
+    return allocationCount;
+}
+
+}
+
+// The array and nothrow forms of the standard library forward here.
+void* operator new(std::size_t size) {
+    geom::allocationCount++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
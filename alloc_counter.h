@@ -0,0 +1,20 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstddef>
+
+namespace geom {
+
+// Counting is opt-in: only programs that link the geometry_alloc_counter
+// object library (alloc_counter.cpp) get operator new and delete replaced by
+// counting wrappers around malloc and free. Everywhere else the standard
+// allocator stays, allocationsCounted() is false and threadAllocations() is 0.
+bool allocationsCounted();
+
+// Calls to the global operator new made by the calling thread so far; take
+// differences around the code to measure.
+size_t threadAllocations();
+
+}
+
+#endif
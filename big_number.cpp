@@ -0,0 +1,434 @@
+#include "big_number.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace geom {
+
+typedef unsigned __int128 uint128;
+
+static const uint64_t DECIMAL_CHUNK = 10000000000000000000ull;
+static const int DECIMAL_CHUNK_DIGITS = 19;
+
+// Measured with bignum_bench over its default sweep: 40 limbs (~770 digits)
+// gives the best mean speedup in most runs, with 48 within noise of it.
+// Relaxed, since a multiply only needs some recent value and setting it
+// while other threads multiply is allowed.
+static std::atomic<size_t> karatsubaThreshold(40);
+
+static uint64_t powerOfTen(int exponent) {
+    uint64_t result = 1;
+    while (exponent-- > 0) result *= 10;
+    return result;
+}
+
+void BigNumber::reserveLimbs(size_t count) {
+    if (heapLimbs.empty()) {
+        if (count <= INLINE_LIMBS) return;
+        heapLimbs.assign(count, 0);
+        std::copy(inlineLimbs, inlineLimbs + length, heapLimbs.begin());
+    } else if (count > heapLimbs.size()) {
+        heapLimbs.resize(std::max(count, 2 * heapLimbs.size()), 0);
+    }
+}
+
+void BigNumber::removeLeadingZeros() {
+    const uint64_t* data = limbs();
+    while (length > 0 && data[length - 1] == 0) length--;
+    if (length == 0) negative = false;
+}
+
+// this = this * factor + addend
+void BigNumber::multiplySmall(uint64_t factor, uint64_t addend) {
+    uint64_t* data = limbs();
+    uint64_t carry = addend;
+    for (size_t i = 0; i < length; i++) {
+        uint128 product = uint128(data[i]) * factor + carry;
+        data[i] = uint64_t(product);
+        carry = uint64_t(product >> 64);
+    }
+    if (carry != 0) {
+        reserveLimbs(length + 1);
+        limbs()[length++] = carry;
+    }
+}
+
+// this = this / divisor, returning the remainder
+uint64_t BigNumber::divideSmall(uint64_t divisor) {
+    uint64_t* data = limbs();
+    uint64_t remainder = 0;
+    for (size_t i = length; i-- > 0;) {
+        uint128 current = (uint128(remainder) << 64) | data[i];
+        data[i] = uint64_t(current / divisor);
+        remainder = uint64_t(current % divisor);
+    }
+    removeLeadingZeros();
+    return remainder;
+}
+
+// Magnitude comparison of trimmed limb arrays.
+static int compareLimbs(const uint64_t* x, size_t nx, const uint64_t* y, size_t ny) {
+    if (nx != ny) return nx < ny ? -1 : 1;
+    for (size_t i = nx; i-- > 0;) {
+        if (x[i] != y[i]) return x[i] < y[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+int BigNumber::compareMagnitude(const BigNumber& a, const BigNumber& b) {
+    return compareLimbs(a.limbs(), a.length, b.limbs(), b.length);
+}
+
+// this += (sourceNegative ? -1 : 1) * source, where source is a trimmed limb
+// array that does not alias this number.
+void BigNumber::addSigned(const uint64_t* source, size_t count, bool sourceNegative) {
+    if (count == 0) return;
+
+    if (length == 0 || negative == sourceNegative) {
+        size_t longest = std::max(length, count);
+        reserveLimbs(longest + 1);
+        uint64_t* out = limbs();
+        std::fill(out + length, out + longest + 1, 0);
+
+        uint64_t carry = 0;
+        size_t i = 0;
+        for (; i < count; i++) {
+            uint128 sum = uint128(out[i]) + source[i] + carry;
+            out[i] = uint64_t(sum);
+            carry = uint64_t(sum >> 64);
+        }
+        for (; carry != 0; i++) {
+            carry = ++out[i] == 0 ? 1 : 0;
+        }
+        length = longest + 1;
+        negative = sourceNegative;
+        removeLeadingZeros();
+        return;
+    }
+
+    uint64_t* out = limbs();
+    int magnitude = compareLimbs(out, length, source, count);
+    if (magnitude == 0) {
+        length = 0;
+        negative = false;
+        return;
+    }
+
+    uint64_t borrow = 0;
+    if (magnitude > 0) {
+        // |this| - |source| keeps the sign of this.
+        for (size_t i = 0; i < length; i++) {
+            uint128 diff = uint128(out[i]) - (i < count ? source[i] : 0) - borrow;
+            out[i] = uint64_t(diff);
+            borrow = uint64_t(diff >> 64) != 0 ? 1 : 0;
+        }
+    } else {
+        // |source| - |this| takes the sign of the source.
+        reserveLimbs(count);
+        out = limbs();
+        std::fill(out + length, out + count, 0);
+        for (size_t i = 0; i < count; i++) {
+            uint128 diff = uint128(source[i]) - out[i] - borrow;
+            out[i] = uint64_t(diff);
+            borrow = uint64_t(diff >> 64) != 0 ? 1 : 0;
+        }
+        length = count;
+        negative = sourceNegative;
+    }
+    removeLeadingZeros();
+}
+
+BigNumber::BigNumber() : inlineLimbs(), length(0), negative(false) {}
+
+BigNumber::BigNumber(const char* str) : BigNumber() {
+    const char* p = str;
+    bool minus = false;
+    if (*p == '-') {
+        minus = true;
+        p++;
+    }
+
+    uint64_t chunk = 0;
+    int digits = 0;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        chunk = chunk * 10 + uint64_t(*p - '0');
+        if (++digits == DECIMAL_CHUNK_DIGITS) {
+            multiplySmall(DECIMAL_CHUNK, chunk);
+            chunk = 0;
+            digits = 0;
+        }
+    }
+    if (digits > 0) multiplySmall(powerOfTen(digits), chunk);
+
+    negative = minus;
+    removeLeadingZeros();
+}
+
+BigNumber::BigNumber(const std::string& str) : BigNumber(str.c_str()) {}
+
+std::string BigNumber::toString() const {
+    if (isZero()) return "0";
+
+    BigNumber rest = *this;
+    std::vector<uint64_t> chunks;
+    while (!rest.isZero()) {
+        chunks.push_back(rest.divideSmall(DECIMAL_CHUNK));
+    }
+
+    std::string result = negative ? "-" : "";
+    result += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        std::string digits = std::to_string(chunks[i]);
+        result.append(DECIMAL_CHUNK_DIGITS - digits.size(), '0');
+        result += digits;
+    }
+    return result;
+}
+
+int BigNumber::compare(const BigNumber& other) const {
+    if (negative && !other.negative) return -1;
+    if (!negative && other.negative) return 1;
+
+    int magnitude = compareMagnitude(*this, other);
+    return negative ? -magnitude : magnitude;
+}
+
+bool BigNumber::isZero() const {
+    return length == 0;
+}
+
+bool BigNumber::toInt64(int64_t& value) const {
+    if (length == 0) {
+        value = 0;
+        return true;
+    }
+    uint64_t magnitude = limbs()[0];
+    if (length > 1 || magnitude > (negative ? uint64_t(1) << 63 : INT64_MAX)) return false;
+    value = negative ? int64_t(0 - magnitude) : int64_t(magnitude);
+    return true;
+}
+
+BigNumber& BigNumber::negate() {
+    if (length != 0) negative = !negative;
+    return *this;
+}
+
+BigNumber& BigNumber::multiplyPowerOfTen(int exponent) {
+    if (length == 0) return *this;
+    for (; exponent >= DECIMAL_CHUNK_DIGITS; exponent -= DECIMAL_CHUNK_DIGITS) {
+        multiplySmall(DECIMAL_CHUNK, 0);
+    }
+    if (exponent > 0) multiplySmall(powerOfTen(exponent), 0);
+    return *this;
+}
+
+BigNumber BigNumber::subtract(const BigNumber& other) const {
+    BigNumber res = *this;
+    res -= other;
+    return res;
+}
+
+BigNumber BigNumber::add(const BigNumber& other) const {
+    BigNumber res = *this;
+    res += other;
+    return res;
+}
+
+BigNumber& BigNumber::operator+=(const BigNumber& other) {
+    if (&other == this) {
+        multiplySmall(2, 0);
+        return *this;
+    }
+    addSigned(other.limbs(), other.length, other.negative);
+    return *this;
+}
+
+BigNumber& BigNumber::operator-=(const BigNumber& other) {
+    if (&other == this) {
+        length = 0;
+        negative = false;
+        return *this;
+    }
+    addSigned(other.limbs(), other.length, !other.negative);
+    return *this;
+}
+
+// out[0, nx + ny) = x * y
+static void multiplySchoolbook(const uint64_t* x, size_t nx, const uint64_t* y, size_t ny, uint64_t* out) {
+    std::fill(out, out + nx + ny, 0);
+    for (size_t i = 0; i < nx; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < ny; j++) {
+            uint128 product = uint128(x[i]) * y[j] + out[i + j] + carry;
+            out[i + j] = uint64_t(product);
+            carry = uint64_t(product >> 64);
+        }
+        out[i + ny] = carry;
+    }
+}
+
+// out[0, n) += x[0, nx) with nx <= n; a carry out of out[n - 1] is dropped.
+static void addInto(uint64_t* out, size_t n, const uint64_t* x, size_t nx) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < nx; i++) {
+        uint128 sum = uint128(out[i]) + x[i] + carry;
+        out[i] = uint64_t(sum);
+        carry = uint64_t(sum >> 64);
+    }
+    for (; carry != 0 && i < n; i++) {
+        carry = ++out[i] == 0 ? 1 : 0;
+    }
+}
+
+// out[0, n) -= x[0, nx); the caller guarantees a non-negative result.
+static void subtractInto(uint64_t* out, size_t n, const uint64_t* x, size_t nx) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < nx; i++) {
+        uint128 diff = uint128(out[i]) - x[i] - borrow;
+        out[i] = uint64_t(diff);
+        borrow = uint64_t(diff >> 64) != 0 ? 1 : 0;
+    }
+    for (; borrow != 0 && i < n; i++) {
+        borrow = out[i]-- == 0 ? 1 : 0;
+    }
+}
+
+static void multiplyLimbs(const uint64_t* x, size_t nx, const uint64_t* y, size_t ny, uint64_t* out);
+
+// x * y = z2 * B^2m + ((x0 + x1)(y0 + y1) - z0 - z2) * B^m + z0, for nx >= ny > m.
+static void multiplyKaratsuba(const uint64_t* x, size_t nx, const uint64_t* y, size_t ny, uint64_t* out) {
+    size_t m = (nx + 1) / 2;
+    const uint64_t* x1 = x + m;
+    const uint64_t* y1 = y + m;
+    size_t nx1 = nx - m, ny1 = ny - m;
+
+    std::fill(out, out + nx + ny, 0);
+    multiplyLimbs(x, m, y, m, out);
+    multiplyLimbs(x1, nx1, y1, ny1, out + 2 * m);
+
+    std::vector<uint64_t> sx(x, x + m), sy(y, y + m);
+    sx.push_back(0);
+    sy.push_back(0);
+    addInto(sx.data(), sx.size(), x1, nx1);
+    addInto(sy.data(), sy.size(), y1, ny1);
+
+    std::vector<uint64_t> middle(sx.size() + sy.size());
+    multiplyLimbs(sx.data(), sx.size(), sy.data(), sy.size(), middle.data());
+    subtractInto(middle.data(), middle.size(), out, 2 * m);
+    subtractInto(middle.data(), middle.size(), out + 2 * m, nx1 + ny1);
+
+    size_t used = middle.size();
+    while (used > 0 && middle[used - 1] == 0) used--;
+    addInto(out + m, nx + ny - m, middle.data(), used);
+}
+
+// out[0, nx + ny) = x * y; out must not overlap the inputs.
+static void multiplyLimbs(const uint64_t* x, size_t nx, const uint64_t* y, size_t ny, uint64_t* out) {
+    if (nx < ny) {
+        std::swap(x, y);
+        std::swap(nx, ny);
+    }
+    if (ny < karatsubaThreshold.load(std::memory_order_relaxed)) {
+        multiplySchoolbook(x, nx, y, ny, out);
+        return;
+    }
+    if (ny > (nx + 1) / 2) {
+        multiplyKaratsuba(x, nx, y, ny, out);
+        return;
+    }
+
+    // Unbalanced: multiply ny-limb slices of x and accumulate.
+    std::fill(out, out + nx + ny, 0);
+    std::vector<uint64_t> partial(2 * ny);
+    for (size_t offset = 0; offset < nx; offset += ny) {
+        size_t slice = std::min(ny, nx - offset);
+        multiplyLimbs(x + offset, slice, y, ny, partial.data());
+        addInto(out + offset, nx + ny - offset, partial.data(), slice + ny);
+    }
+}
+
+size_t BigNumber::multiplyThreshold() {
+    return karatsubaThreshold.load(std::memory_order_relaxed);
+}
+
+void BigNumber::setMultiplyThreshold(size_t limbs) {
+    karatsubaThreshold.store(std::max<size_t>(limbs, 4), std::memory_order_relaxed);
+}
+
+BigNumber BigNumber::multiply(const BigNumber& other) const {
+    if (isZero() || other.isZero()) return BigNumber();
+
+    BigNumber res;
+    res.reserveLimbs(length + other.length);
+    multiplyLimbs(limbs(), length, other.limbs(), other.length, res.limbs());
+
+    res.length = length + other.length;
+    res.negative = negative != other.negative;
+    res.removeLeadingZeros();
+    return res;
+}
+
+// Products of up to PRODUCT_STACK_LIMBS limbs use a stack buffer.
+static const size_t PRODUCT_STACK_LIMBS = 16;
+
+// Trimmed length of a * b written to out, which holds na + nb limbs.
+static size_t productLimbs(const uint64_t* a, size_t na, const uint64_t* b, size_t nb, uint64_t* out) {
+    multiplyLimbs(a, na, b, nb, out);
+    size_t count = na + nb;
+    while (count > 0 && out[count - 1] == 0) count--;
+    return count;
+}
+
+void BigNumber::accumulateProduct(const BigNumber& a, const BigNumber& b, bool subtract) {
+    if (a.isZero() || b.isZero()) return;
+
+    bool productNegative = (a.negative != b.negative) != subtract;
+    size_t size = a.length + b.length;
+    if (size <= PRODUCT_STACK_LIMBS) {
+        uint64_t product[PRODUCT_STACK_LIMBS];
+        size_t count = productLimbs(a.limbs(), a.length, b.limbs(), b.length, product);
+        addSigned(product, count, productNegative);
+    } else {
+        std::vector<uint64_t> product(size);
+        size_t count = productLimbs(a.limbs(), a.length, b.limbs(), b.length, product.data());
+        addSigned(product.data(), count, productNegative);
+    }
+}
+
+BigNumber& BigNumber::addProduct(const BigNumber& a, const BigNumber& b) {
+    accumulateProduct(a, b, false);
+    return *this;
+}
+
+BigNumber& BigNumber::subtractProduct(const BigNumber& a, const BigNumber& b) {
+    accumulateProduct(a, b, true);
+    return *this;
+}
+
+int BigNumber::determinantSign(const BigNumber& a, const BigNumber& b,
+                               const BigNumber& c, const BigNumber& d) {
+    int first = a.sign() * d.sign();
+    int second = b.sign() * c.sign();
+    if (first != second || first == 0) return first > second ? 1 : (first < second ? -1 : 0);
+
+    // Same non-zero sign: compare |a * d| with |b * c|.
+    size_t sizeAD = a.length + d.length;
+    size_t sizeBC = b.length + c.length;
+    int magnitude;
+    if (sizeAD <= PRODUCT_STACK_LIMBS && sizeBC <= PRODUCT_STACK_LIMBS) {
+        uint64_t ad[PRODUCT_STACK_LIMBS], bc[PRODUCT_STACK_LIMBS];
+        size_t countAD = productLimbs(a.limbs(), a.length, d.limbs(), d.length, ad);
+        size_t countBC = productLimbs(b.limbs(), b.length, c.limbs(), c.length, bc);
+        magnitude = compareLimbs(ad, countAD, bc, countBC);
+    } else {
+        std::vector<uint64_t> ad(sizeAD), bc(sizeBC);
+        size_t countAD = productLimbs(a.limbs(), a.length, d.limbs(), d.length, ad.data());
+        size_t countBC = productLimbs(b.limbs(), b.length, c.limbs(), c.length, bc.data());
+        magnitude = compareLimbs(ad.data(), countAD, bc.data(), countBC);
+    }
+    return first * magnitude;
+}
+
+}
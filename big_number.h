@@ -0,0 +1,79 @@
+#ifndef BIG_NUMBER_H
+#define BIG_NUMBER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace geom {
+
+// Sign and magnitude on little-endian 64-bit limbs. Up to INLINE_LIMBS limbs
+// (256 bits) live inside the object; longer values spill to the heap. Decimal
+// text is only handled by the string constructors and toString().
+class BigNumber {
+private:
+    static const size_t INLINE_LIMBS = 4;
+
+    uint64_t inlineLimbs[INLINE_LIMBS];
+    std::vector<uint64_t> heapLimbs;
+    size_t length;
+    bool negative;
+
+    uint64_t* limbs() { return heapLimbs.empty() ? inlineLimbs : heapLimbs.data(); }
+    const uint64_t* limbs() const { return heapLimbs.empty() ? inlineLimbs : heapLimbs.data(); }
+
+    void reserveLimbs(size_t count);
+    void removeLeadingZeros();
+    uint64_t divideSmall(uint64_t divisor);
+
+    void addSigned(const uint64_t* source, size_t count, bool sourceNegative);
+    void accumulateProduct(const BigNumber& a, const BigNumber& b, bool subtract);
+
+    static int compareMagnitude(const BigNumber& a, const BigNumber& b);
+
+public:
+    BigNumber();
+    // Optional '-' and leading decimal digits; reading stops at the first other
+    // character, so "1.5" is 1. Decimal handles fractional text.
+    BigNumber(const char* str);
+    BigNumber(const std::string& str);
+
+    std::string toString() const;
+    int compare(const BigNumber& other) const;
+    bool isZero() const;
+
+    BigNumber subtract(const BigNumber& other) const;
+    BigNumber add(const BigNumber& other) const;
+    BigNumber multiply(const BigNumber& other) const;
+    int sign() const { return length == 0 ? 0 : (negative ? -1 : 1); }
+    // False when the value does not fit int64_t.
+    bool toInt64(int64_t& value) const;
+    BigNumber& negate();
+
+    // this = this * factor + addend on the magnitude; the sign is kept.
+    void multiplySmall(uint64_t factor, uint64_t addend);
+    BigNumber& multiplyPowerOfTen(int exponent);
+
+    // In-place forms reuse this number's limbs; they accept aliased arguments.
+    BigNumber& operator+=(const BigNumber& other);
+    BigNumber& operator-=(const BigNumber& other);
+    // this += a * b and this -= a * b without a BigNumber for the product.
+    BigNumber& addProduct(const BigNumber& a, const BigNumber& b);
+    BigNumber& subtractProduct(const BigNumber& a, const BigNumber& b);
+
+    // sign(a * d - b * c). Operands of up to INLINE_LIMBS limbs are multiplied
+    // into stack buffers, and products of different sign are never formed.
+    static int determinantSign(const BigNumber& a, const BigNumber& b,
+                               const BigNumber& c, const BigNumber& d);
+
+    // Operand size in limbs from which multiply() switches from schoolbook to
+    // Karatsuba (at least 4); SIZE_MAX disables it. bignum_bench measures the crossover.
+    // It may be changed while other threads multiply.
+    static size_t multiplyThreshold();
+    static void setMultiplyThreshold(size_t limbs);
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "big_number.h"
+
+using namespace geom;
+
+// Sweeps operand sizes and times BigNumber::multiply with Karatsuba disabled
+// and at a few crossover thresholds, then suggests the threshold with the best
+// geometric mean speedup over schoolbook across the sweep.
+//
+// usage: bignum_bench [max limbs] [milliseconds per measurement]
+
+static BigNumber randomNumber(std::mt19937_64& rng, size_t limbs) {
+    // 19 decimal digits hold a little more than 63 bits; pad to the limb count.
+    size_t digits = limbs * 64 * 30103 / 100000;
+    std::string text(digits, '0');
+    text[0] = char('1' + rng() % 9);
+    for (size_t i = 1; i < digits; i++) text[i] = char('0' + rng() % 10);
+    return BigNumber(text);
+}
+
+static double timeMultiply(const BigNumber& a, const BigNumber& b, double budgetMs) {
+    typedef std::chrono::steady_clock Clock;
+    size_t rounds = 0;
+    size_t batch = 1;
+    size_t sink = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < budgetMs * 1e6) {
+        for (size_t i = 0; i < batch; i++) {
+            sink += a.multiply(b).isZero() ? 0 : 1;
+        }
+        rounds += batch;
+        batch *= 2;
+        elapsed = double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+    if (sink != rounds) std::fprintf(stderr, "unexpected zero product\n");
+    return elapsed / double(rounds);
+}
+
+// Best of three runs, to keep scheduler noise out of the comparison.
+static double nanosecondsPerMultiply(const BigNumber& a, const BigNumber& b, double budgetMs) {
+    double best = timeMultiply(a, b, budgetMs / 3);
+    for (int run = 1; run < 3; run++) best = std::min(best, timeMultiply(a, b, budgetMs / 3));
+    return best;
+}
+
+int main(int argc, char** argv) {
+    size_t maxLimbs = argc > 1 ? size_t(std::strtoul(argv[1], nullptr, 10)) : 512;
+    double budgetMs = argc > 2 ? std::atof(argv[2]) : 50;
+    const size_t thresholds[] = {16, 24, 32, 40, 48, 64};
+    const size_t thresholdCount = sizeof(thresholds) / sizeof(thresholds[0]);
+
+    size_t saved = BigNumber::multiplyThreshold();
+    std::mt19937_64 rng(12345);
+
+    std::printf("%8s %14s", "limbs", "schoolbook");
+    for (size_t t : thresholds) std::printf("    karatsuba@%-3zu", t);
+    std::printf("\n");
+
+    std::vector<double> logSpeedup(thresholdCount, 0);
+    for (size_t limbs = 8; limbs <= maxLimbs; limbs += limbs < 64 ? 8 : limbs / 4) {
+        BigNumber a = randomNumber(rng, limbs);
+        BigNumber b = randomNumber(rng, limbs);
+
+        BigNumber::setMultiplyThreshold(SIZE_MAX);
+        double schoolbook = nanosecondsPerMultiply(a, b, budgetMs);
+        std::printf("%8zu %12.0fns", limbs, schoolbook);
+
+        for (size_t i = 0; i < thresholdCount; i++) {
+            BigNumber::setMultiplyThreshold(thresholds[i]);
+            double ns = nanosecondsPerMultiply(a, b, budgetMs);
+            logSpeedup[i] += std::log(schoolbook / ns);
+            std::printf(" %14.0fns", ns);
+        }
+        std::printf("\n");
+    }
+
+    BigNumber::setMultiplyThreshold(saved);
+    size_t best = size_t(std::max_element(logSpeedup.begin(), logSpeedup.end()) - logSpeedup.begin());
+    std::printf("suggested threshold: %zu limbs (compiled: %zu)\n", thresholds[best], saved);
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include "box_tree.h"
+
+#include <algorithm>
+
+namespace geom {
+
+IntBox::IntBox(const IntPoint& a, const IntPoint& b)
+    : minX(std::min(a.x, b.x)), minY(std::min(a.y, b.y)),
+      maxX(std::max(a.x, b.x)), maxY(std::max(a.y, b.y)) {}
+
+bool IntBox::overlaps(const IntBox& other) const {
+    return minX <= other.maxX && other.minX <= maxX &&
+           minY <= other.maxY && other.minY <= maxY;
+}
+
+bool IntBox::contains(const IntBox& other) const {
+    return minX <= other.minX && minY <= other.minY &&
+           other.maxX <= maxX && other.maxY <= maxY;
+}
+
+IntBox IntBox::merged(const IntBox& other) const {
+    IntBox result;
+    result.minX = std::min(minX, other.minX);
+    result.minY = std::min(minY, other.minY);
+    result.maxX = std::max(maxX, other.maxX);
+    result.maxY = std::max(maxY, other.maxY);
+    return result;
+}
+
+IntBox IntBox::inflated(int32_t amount) const {
+    IntBox result;
+    result.minX = minX - amount;
+    result.minY = minY - amount;
+    result.maxX = maxX + amount;
+    result.maxY = maxY + amount;
+    return result;
+}
+
+int64_t IntBox::perimeter() const {
+    return 2 * (int64_t(maxX) - minX + int64_t(maxY) - minY);
+}
+
+DynamicBoxTree::DynamicBoxTree(int32_t margin)
+    : root(NULL_NODE), freeList(NULL_NODE), leafCount(0), margin(margin) {}
+
+void DynamicBoxTree::clear() {
+    nodes.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    leafCount = 0;
+}
+
+int DynamicBoxTree::allocateNode() {
+    int node;
+    if (freeList != NULL_NODE) {
+        node = freeList;
+        freeList = nodes[node].parent;
+    } else {
+        node = int(nodes.size());
+        nodes.emplace_back();
+    }
+    Node& n = nodes[node];
+    n.parent = n.left = n.right = NULL_NODE;
+    n.height = 0;
+    n.item = 0;
+    return node;
+}
+
+void DynamicBoxTree::freeNode(int node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int DynamicBoxTree::insert(uint32_t item, const IntBox& box) {
+    int leaf = allocateNode();
+    nodes[leaf].box = box.inflated(margin);
+    nodes[leaf].item = item;
+    insertLeaf(leaf);
+    leafCount++;
+    return leaf;
+}
+
+void DynamicBoxTree::remove(int proxy) {
+    removeLeaf(proxy);
+    freeNode(proxy);
+    leafCount--;
+}
+
+bool DynamicBoxTree::update(int proxy, const IntBox& box) {
+    if (nodes[proxy].box.contains(box)) return false;
+
+    removeLeaf(proxy);
+    nodes[proxy].box = box.inflated(margin);
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicBoxTree::query(const IntBox& box, std::vector<uint32_t>& hits) const {
+    if (root == NULL_NODE) return;
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        if (!node.box.overlaps(box)) continue;
+
+        if (node.isLeaf()) {
+            hits.push_back(node.item);
+        } else {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+}
+
+// Descends towards the sibling with the smallest growth in perimeter.
+void DynamicBoxTree::insertLeaf(int leaf) {
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    IntBox leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].isLeaf()) {
+        int left = nodes[index].left;
+        int right = nodes[index].right;
+
+        int64_t perimeter = nodes[index].box.perimeter();
+        int64_t combined = nodes[index].box.merged(leafBox).perimeter();
+        int64_t cost = 2 * combined;
+        int64_t inheritance = 2 * (combined - perimeter);
+
+        auto descentCost = [&](int child) {
+            IntBox box = leafBox.merged(nodes[child].box);
+            if (nodes[child].isLeaf()) return box.perimeter() + inheritance;
+            return box.perimeter() - nodes[child].box.perimeter() + inheritance;
+        };
+        int64_t costLeft = descentCost(left);
+        int64_t costRight = descentCost(right);
+
+        if (cost < costLeft && cost < costRight) break;
+        index = costLeft < costRight ? left : right;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = leafBox.merged(nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].left = sibling;
+    nodes[newParent].right = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != NULL_NODE) {
+        if (nodes[oldParent].left == sibling) {
+            nodes[oldParent].left = newParent;
+        } else {
+            nodes[oldParent].right = newParent;
+        }
+    } else {
+        root = newParent;
+    }
+
+    refit(nodes[leaf].parent);
+}
+
+void DynamicBoxTree::removeLeaf(int leaf) {
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    if (grandParent != NULL_NODE) {
+        if (nodes[grandParent].left == parent) {
+            nodes[grandParent].left = sibling;
+        } else {
+            nodes[grandParent].right = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        refit(grandParent);
+    } else {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+    }
+}
+
+void DynamicBoxTree::refit(int node) {
+    while (node != NULL_NODE) {
+        node = balance(node);
+
+        int left = nodes[node].left;
+        int right = nodes[node].right;
+        nodes[node].height = 1 + std::max(nodes[left].height, nodes[right].height);
+        nodes[node].box = nodes[left].box.merged(nodes[right].box);
+
+        node = nodes[node].parent;
+    }
+}
+
+// Rotates the taller grandchild up when the subtrees of a differ in height by
+// more than one; returns the node now at a's position.
+int DynamicBoxTree::balance(int a) {
+    Node& A = nodes[a];
+    if (A.isLeaf() || A.height < 2) return a;
+
+    int b = A.left;
+    int c = A.right;
+    int heightDiff = nodes[c].height - nodes[b].height;
+    if (heightDiff < -1) {
+        std::swap(b, c);
+    } else if (heightDiff <= 1) {
+        return a;
+    }
+
+    // c is the taller child; lift it above a.
+    Node& C = nodes[c];
+    int f = C.left;
+    int g = C.right;
+
+    C.left = a;
+    C.parent = A.parent;
+    A.parent = c;
+
+    if (C.parent != NULL_NODE) {
+        if (nodes[C.parent].left == a) {
+            nodes[C.parent].left = c;
+        } else {
+            nodes[C.parent].right = c;
+        }
+    } else {
+        root = c;
+    }
+
+    int keep = f, move = g;
+    if (nodes[f].height < nodes[g].height) std::swap(keep, move);
+    C.right = keep;
+    if (A.left == c) {
+        A.left = move;
+    } else {
+        A.right = move;
+    }
+    nodes[move].parent = a;
+
+    A.box = nodes[A.left].box.merged(nodes[A.right].box);
+    C.box = A.box.merged(nodes[keep].box);
+    A.height = 1 + std::max(nodes[A.left].height, nodes[A.right].height);
+    C.height = 1 + std::max(A.height, nodes[keep].height);
+    return c;
+}
+
+}
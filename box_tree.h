@@ -0,0 +1,72 @@
+#ifndef BOX_TREE_H
+#define BOX_TREE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "geometry.h"
+
+namespace geom {
+
+struct IntBox {
+    int32_t minX, minY, maxX, maxY;
+
+    IntBox() : minX(0), minY(0), maxX(0), maxY(0) {}
+    IntBox(const IntPoint& a, const IntPoint& b);
+
+    bool overlaps(const IntBox& other) const;
+    bool contains(const IntBox& other) const;
+    IntBox merged(const IntBox& other) const;
+    IntBox inflated(int32_t margin) const;
+    int64_t perimeter() const;
+};
+
+// Dynamic AABB tree over items such as segments. Leaves store boxes inflated by
+// a margin, so an item moved by less than the margin keeps its leaf and only a
+// larger move reinserts it; height stays O(log n) through AVL-style rotations.
+class DynamicBoxTree {
+public:
+    explicit DynamicBoxTree(int32_t margin = 8);
+
+    void clear();
+    size_t size() const { return leafCount; }
+
+    int insert(uint32_t item, const IntBox& box);
+    void remove(int proxy);
+    // Returns true when the item left its fat box and was reinserted.
+    bool update(int proxy, const IntBox& box);
+
+    // Items whose fat box overlaps the query box; callers filter exactly.
+    void query(const IntBox& box, std::vector<uint32_t>& hits) const;
+
+private:
+    static constexpr int NULL_NODE = -1;
+
+    struct Node {
+        IntBox box;
+        uint32_t item;
+        int parent;
+        int left;
+        int right;
+        int height;
+        bool isLeaf() const { return left == NULL_NODE; }
+    };
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int node);
+    void refit(int node);
+
+    std::vector<Node> nodes;
+    int root;
+    int freeList;
+    size_t leafCount;
+    int32_t margin;
+    mutable std::vector<int> stack;
+};
+
+}
+
+#endif
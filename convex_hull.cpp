@@ -1,61 +1,103 @@
 #include "convex_hull.h"
 
-ConvexHullWidget::ConvexHullWidget(QWidget *parent) : QWidget(parent), onlineMode(false) {
+static bool wrapHull(const HullRequest& request, HullFrame& frame,
+                     std::vector<size_t>& hullIndices, const std::atomic<bool>& cancelled) {
+    size_t before = geom::threadAllocations();
+    frame.timing.begin();
+    frame.preview = request.preview;
+    frame.hull.clear();
+    geom::convexHull(request.points.span(), hullIndices, &cancelled);
+    for (size_t idx : hullIndices) {
+        frame.hull.emplace_back(request.points.x(idx), request.points.y(idx));
+    }
+    frame.timing.end();
+
+    frame.allocations = request.allocations + geom::threadAllocations() - before;
+    return !cancelled;
+}
+
+ConvexHullWidget::ConvexHullWidget(QWidget *parent)
+    : QWidget(parent), onlineMode(false),
+      scheduler([this](bool preview) { submitHull(preview); }),
+      worker([this](const HullRequest& request, HullFrame& frame, const std::atomic<bool>& cancelled) {
+                 if (wrapHull(request, frame, hullIndices, cancelled)) return true;
+                 // Superseded full runs never reach frameReady(), so report their time here.
+                 if (!request.preview) {
+                     double ms = frame.timing.elapsedMs();
+                     QMetaObject::invokeMethod(this, [this, ms] { scheduler.reportAbandoned(ms); },
+                                               Qt::QueuedConnection);
+                 }
+                 return false;
+             },
+             [this] { QMetaObject::invokeMethod(this, [this] { frameReady(); }, Qt::QueuedConnection); }) {
     setMouseTracking(true);
     setMinimumSize(800, 600);
 }
 
 void ConvexHullWidget::clearPoints() {
     points.clear();
-    convexHull.clear();
+    computeConvexHull();
     update();
 }
 
-int ConvexHullWidget::orientation(const QPointF& p, const QPointF& q, const QPointF& r) {
-    double val = (q.y() - p.y()) * (r.x() - q.x()) - (q.x() - p.x()) * (r.y() - q.y());
-    if (val == 0) return 0;
-    return (val > 0) ? 1 : 2;
-}
-
 void ConvexHullWidget::computeConvexHull() {
-    if (points.size() < 3) {
-        convexHull.clear();
-        update();
-        return;
-    }
-
-    convexHull.clear();
+    submitHull(false);
+}
 
-    int startIndex = 0;
-    for (int i = 1; i < points.size(); i++) {
-        if (points[i].pos.y() < points[startIndex].pos.y() ||
-            (points[i].pos.y() == points[startIndex].pos.y() &&
-             points[i].pos.x() < points[startIndex].pos.x())) {
-            startIndex = i;
+// Queues the current coordinates for the worker; newer calls supersede older ones.
+void ConvexHullWidget::submitHull(bool preview) {
+    size_t before = geom::threadAllocations();
+    HullRequest& request = worker.draft();
+    request.preview = preview;
+    size_t stride = preview ? points.size() / PREVIEW_POINTS + 1 : 1;
+    if (stride == 1) {
+        request.points = points;
+    } else {
+        request.points.clear();
+        request.points.reserve(points.size() / stride + 1);
+        for (size_t i = 0; i < points.size(); i++) {
+            if (i % stride == 0 || points.selected(i)) {
+                request.points.add(points.x(i), points.y(i));
+            }
         }
     }
 
-    std::vector<int> hullIndices;
-    int current = startIndex;
+    request.allocations = geom::threadAllocations() - before;
+    worker.submit();
+}
 
-    do {
-        hullIndices.push_back(current);
-        int next = (current + 1) % points.size();
+void ConvexHullWidget::frameReady() {
+    const HullFrame& frame = worker.latest();
+    if (!frame.preview) scheduler.reportCost(frame.timing.elapsedMs());
+    update();
+}
 
-        for (int i = 0; i < points.size(); i++) {
-            if (orientation(points[current].pos, points[i].pos, points[next].pos) == 2) {
-                next = i;
-            }
-        }
+bool ConvexHullWidget::loadScene(const std::string& path, std::string& error) {
+    auto scene = std::make_shared<geom::MappedScene>();
+    if (!scene->open(path, error)) return false;
+    const geom::SceneSection* section = scene->find(geom::SCENE_POINTS);
+    if (!section) {
+        error = path + ": no points";
+        return false;
+    }
 
-        current = next;
-    } while (current != startIndex);
+    // The points stay in the mapping until the first edit.
+    points.view(scene->xs(*section), scene->ys(*section), size_t(section->count), scene);
+    computeConvexHull();
+    update();
+    return true;
+}
 
-    for (int idx : hullIndices) {
-        convexHull.push_back(points[idx].pos);
+bool ConvexHullWidget::saveScene(const std::string& path, std::string& error) {
+    std::vector<geom::Point> hull;
+    for (const auto& point : worker.latest().hull) {
+        hull.emplace_back(point.x(), point.y());
     }
 
-    update();
+    geom::SceneWriter writer;
+    writer.addPoints(points.xs(), points.ys(), points.size());
+    if (!hull.empty()) writer.addRing(hull.data(), hull.size(), 0, false);
+    return writer.write(path, error);
 }
 
 void ConvexHullWidget::paintEvent(QPaintEvent *event) {
@@ -64,10 +106,13 @@ void ConvexHullWidget::paintEvent(QPaintEvent *event) {
     painter.setRenderHint(QPainter::Antialiasing);
     painter.fillRect(rect(), Qt::white);
 
+    const HullFrame& frame = worker.latest();
+    const std::vector<QPointF>& convexHull = frame.hull;
+
     painter.setPen(Qt::black);
     painter.setBrush(Qt::blue);
-    for (const auto& point : points) {
-        painter.drawEllipse(point.pos, 5, 5);
+    for (size_t i = 0; i < points.size(); i++) {
+        painter.drawEllipse(QPointF(points.x(i), points.y(i)), 5, 5);
     }
 
     if (convexHull.size() >= 3) {
@@ -84,21 +129,23 @@ void ConvexHullWidget::paintEvent(QPaintEvent *event) {
     painter.drawText(10, 20, QString("Точек: %1").arg(points.size()));
     painter.drawText(10, 40, QString("Вершин оболочки: %1").arg(convexHull.size()));
     painter.drawText(10, 60, onlineMode ? "Режим: Онлайн" : "Режим: Обычный");
+    painter.drawText(10, 80, QString("Выделений памяти: %1").arg(geom::allocationsCounted() ? QString::number(frame.allocations) : QString("н/д")));
+    if (frame.preview) painter.drawText(10, 100, "Предпросмотр");
+
+    frame.timing.paint(painter, rect());
 }
 
 void ConvexHullWidget::mousePressEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton) {
         QPointF pos = event->position();
-        for (auto& point : points) {
-            QPointF diff = point.pos - pos;
-            if (diff.x() * diff.x() + diff.y() * diff.y() <= 100) {
-                point.isDragging = true;
-                if (onlineMode) computeConvexHull();
-                return;
-            }
+        size_t hit = points.findWithin(pos.x(), pos.y(), 100);
+        if (hit < points.size()) {
+            points.select(hit);
+            if (onlineMode) scheduler.markDirty();
+            return;
         }
-        points.emplace_back(pos);
-        if (onlineMode) computeConvexHull();
+        points.add(pos.x(), pos.y());
+        if (onlineMode) scheduler.markDirty();
         update();
     }
 }
@@ -106,23 +153,23 @@ void ConvexHullWidget::mousePressEvent(QMouseEvent *event) {
 void ConvexHullWidget::mouseMoveEvent(QMouseEvent *event) {
     if (event->buttons() & Qt::LeftButton) {
         QPointF pos = event->position();
-        for (auto& point : points) {
-            if (point.isDragging) {
-                point.pos = pos;
-                if (onlineMode) computeConvexHull();
-                update();
-                return;
-            }
+        size_t dragged = points.firstSelected();
+        if (dragged < points.size()) {
+            points.set(dragged, pos.x(), pos.y());
+            if (onlineMode) scheduler.markDirty();
+            update();
         }
     }
 }
 
 void ConvexHullWidget::mouseReleaseEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton) {
-        for (auto& point : points) {
-            point.isDragging = false;
+        points.clearSelection();
+        if (onlineMode) {
+            scheduler.flush();
+        } else {
+            computeConvexHull();
         }
-        if (!onlineMode) computeConvexHull();
         update();
     }
 }
@@ -141,11 +188,15 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
     QHBoxLayout *controlLayout = new QHBoxLayout();
     QPushButton *clearButton = new QPushButton("Очистить", this);
     QPushButton *computeButton = new QPushButton("Построить оболочку", this);
+    QPushButton *openButton = new QPushButton("Открыть сцену", this);
+    QPushButton *saveButton = new QPushButton("Сохранить сцену", this);
     QCheckBox *onlineCheckbox = new QCheckBox("Онлайн режим", this);
     QLabel *infoLabel = new QLabel("ЛКМ: добавить точку | Перетащить: двигать точку", this);
 
     controlLayout->addWidget(clearButton);
     controlLayout->addWidget(computeButton);
+    controlLayout->addWidget(openButton);
+    controlLayout->addWidget(saveButton);
     controlLayout->addWidget(onlineCheckbox);
     controlLayout->addWidget(infoLabel);
     controlLayout->addStretch();
@@ -154,6 +205,20 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
     connect(clearButton, &QPushButton::clicked, convexHullWidget, &ConvexHullWidget::clearPoints);
     connect(computeButton, &QPushButton::clicked, convexHullWidget, &ConvexHullWidget::computeConvexHull);
     connect(onlineCheckbox, &QCheckBox::toggled, convexHullWidget, &ConvexHullWidget::setOnlineMode);
+    connect(openButton, &QPushButton::clicked, this, [this] {
+        QString path = QFileDialog::getOpenFileName(this, "Открыть сцену", QString(), "Scenes (*.scene);;All files (*)");
+        std::string error;
+        if (!path.isEmpty() && !convexHullWidget->loadScene(path.toLocal8Bit().constData(), error)) {
+            QMessageBox::warning(this, "Ошибка", QString::fromStdString(error));
+        }
+    });
+    connect(saveButton, &QPushButton::clicked, this, [this] {
+        QString path = QFileDialog::getSaveFileName(this, "Сохранить сцену", QString(), "Scenes (*.scene)");
+        std::string error;
+        if (!path.isEmpty() && !convexHullWidget->saveScene(path.toLocal8Bit().constData(), error)) {
+            QMessageBox::warning(this, "Ошибка", QString::fromStdString(error));
+        }
+    });
 
     setWindowTitle("Выпуклая оболочка");
     resize(900, 700);
@@ -10,15 +10,36 @@
 #include <QPushButton>
 #include <QCheckBox>
 #include <QLabel>
+#include <QFileDialog>
+#include <QMessageBox>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <string>
 
-class Point {
-public:
-    QPointF pos;
-    bool isDragging = false;
-    Point(const QPointF& p) : pos(p) {}
+#include "hull_core.h"
+#include "point_set.h"
+#include "trace_overlay.h"
+#include "latest_worker.h"
+#include "frame_scheduler.h"
+#include "scene_file.h"
+#include "alloc_counter.h"
+
+struct HullRequest {
+    geom::PointSet points;
+    bool preview = false;
+    // Heap allocations made while filling it on the GUI thread.
+    size_t allocations = 0;
+};
+
+// A finished hull, in the coordinates it was computed from.
+struct HullFrame {
+    std::vector<QPointF> hull;
+    bool preview = false;
+    // Heap allocations for the request and the run, counted by operator new;
+    // zero once buffers have warmed up.
+    size_t allocations = 0;
+    TraceOverlay timing;
 };
 
 class ConvexHullWidget : public QWidget {
@@ -28,6 +49,9 @@ public:
     ConvexHullWidget(QWidget *parent = nullptr);
     void clearPoints();
     void computeConvexHull();
+    // Points come from the first point section; saving adds the hull as ring 0.
+    bool loadScene(const std::string& path, std::string& error);
+    bool saveScene(const std::string& path, std::string& error);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -36,11 +60,20 @@ protected:
     void mouseReleaseEvent(QMouseEvent *event) override;
 
 private:
-    std::vector<Point> points;
-    std::vector<QPointF> convexHull;
-    bool onlineMode;
+    // Preview hulls wrap every k-th point, at most this many, plus dragged ones.
+    static const size_t PREVIEW_POINTS = 2000;
+
+    void submitHull(bool preview);
+    void frameReady();
 
-    int orientation(const QPointF& p, const QPointF& q, const QPointF& r);
+    // Dragged points are the selected ones.
+    geom::PointSet points;
+    bool onlineMode;
+    FrameScheduler scheduler;
+    // Gift wrapping needs no temporaries besides this; worker thread only.
+    std::vector<size_t> hullIndices;
+    // Destroyed first, so the worker thread is joined while the widget is intact.
+    geom::LatestWinsWorker<HullRequest, HullFrame> worker;
 
 public slots:
     void setOnlineMode(bool enabled);
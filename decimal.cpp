@@ -0,0 +1,205 @@
+#include "decimal.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace geom {
+
+static const int DIGIT_CHUNK = 19;
+// Exponents past this are rejected instead of expanding to huge mantissas.
+static const int EXPONENT_LIMIT = 4096;
+
+static const uint64_t POWERS_OF_TEN[DIGIT_CHUNK + 1] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Appends a run of digits to mantissa * 10^chunkDigits + chunk, flushing the
+// chunk into the mantissa every 19 digits. Returns the end of the run.
+static const char* readDigits(const char* p, const char* last, BigNumber& mantissa,
+                              uint64_t& chunk, int& chunkDigits) {
+    for (; p != last && isDigit(*p); p++) {
+        chunk = chunk * 10 + uint64_t(*p - '0');
+        if (++chunkDigits == DIGIT_CHUNK) {
+            mantissa.multiplySmall(POWERS_OF_TEN[DIGIT_CHUNK], chunk);
+            chunk = 0;
+            chunkDigits = 0;
+        }
+    }
+    return p;
+}
+
+Decimal::Decimal(const BigNumber& mantissa, int scale) : value(mantissa), digitsAfterPoint(scale) {
+    if (digitsAfterPoint < 0) {
+        value.multiplyPowerOfTen(-digitsAfterPoint);
+        digitsAfterPoint = 0;
+    }
+}
+
+Decimal::Decimal(const std::string& text) : Decimal() {
+    if (parse(text.data(), text.data() + text.size(), *this) == nullptr) *this = Decimal();
+}
+
+const char* Decimal::parse(const char* first, const char* last, Decimal& result) {
+    const char* p = first;
+    bool minus = false;
+    if (p != last && (*p == '-' || *p == '+')) {
+        minus = *p == '-';
+        p++;
+    }
+
+    // Digits go straight into the result, which is left unspecified on failure.
+    BigNumber& mantissa = result.value;
+    mantissa = BigNumber();
+    uint64_t chunk = 0;
+    int chunkDigits = 0;
+    const char* integerEnd = readDigits(p, last, mantissa, chunk, chunkDigits);
+    size_t digitCount = size_t(integerEnd - p);
+    p = integerEnd;
+
+    int fractionDigits = 0;
+    if (p != last && *p == '.') {
+        const char* fractionEnd = readDigits(p + 1, last, mantissa, chunk, chunkDigits);
+        fractionDigits = int(fractionEnd - p - 1);
+        digitCount += size_t(fractionDigits);
+        p = fractionEnd;
+    }
+    if (digitCount == 0) return nullptr;
+    if (chunkDigits > 0) mantissa.multiplySmall(POWERS_OF_TEN[chunkDigits], chunk);
+
+    int exponent = 0;
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q != last && (*q == '-' || *q == '+')) {
+            negativeExponent = *q == '-';
+            q++;
+        }
+        if (q != last && isDigit(*q)) {
+            for (; q != last && isDigit(*q); q++) {
+                exponent = exponent * 10 + (*q - '0');
+                if (exponent > EXPONENT_LIMIT) return nullptr;
+            }
+            if (negativeExponent) exponent = -exponent;
+            p = q;
+        }
+    }
+
+    if (minus) mantissa.negate();
+    result.digitsAfterPoint = fractionDigits - exponent;
+    if (result.digitsAfterPoint < 0) {
+        mantissa.multiplyPowerOfTen(-result.digitsAfterPoint);
+        result.digitsAfterPoint = 0;
+    }
+    return p;
+}
+
+BigNumber Decimal::scaledMantissa(int target) const {
+    BigNumber res = value;
+    res.multiplyPowerOfTen(target - digitsAfterPoint);
+    return res;
+}
+
+int Decimal::compare(const Decimal& other) const {
+    if (digitsAfterPoint == other.digitsAfterPoint) return value.compare(other.value);
+    int target = std::max(digitsAfterPoint, other.digitsAfterPoint);
+    return scaledMantissa(target).compare(other.scaledMantissa(target));
+}
+
+Decimal Decimal::add(const Decimal& other) const {
+    int target = std::max(digitsAfterPoint, other.digitsAfterPoint);
+    BigNumber sum = scaledMantissa(target);
+    sum += other.scaledMantissa(target);
+    return Decimal(sum, target);
+}
+
+Decimal Decimal::subtract(const Decimal& other) const {
+    int target = std::max(digitsAfterPoint, other.digitsAfterPoint);
+    BigNumber difference = scaledMantissa(target);
+    difference -= other.scaledMantissa(target);
+    return Decimal(difference, target);
+}
+
+Decimal Decimal::multiply(const Decimal& other) const {
+    return Decimal(value.multiply(other.value), digitsAfterPoint + other.digitsAfterPoint);
+}
+
+std::string Decimal::toString() const {
+    std::string digits = value.toString();
+    if (digitsAfterPoint == 0) return digits;
+
+    bool minus = digits[0] == '-';
+    if (minus) digits.erase(0, 1);
+    if (digits.size() <= size_t(digitsAfterPoint)) {
+        digits.insert(0, digitsAfterPoint + 1 - digits.size(), '0');
+    }
+    digits.insert(digits.size() - digitsAfterPoint, 1, '.');
+    return minus ? "-" + digits : digits;
+}
+
+double Decimal::toDouble() const {
+    double result;
+    if (nearestDouble(result)) return result;
+    return std::strtod(toString().c_str(), nullptr);
+}
+
+// Both m < 2^53 and 10^scale <= 10^22 are exact doubles, so one division
+// rounds correctly.
+bool Decimal::nearestDouble(double& result) const {
+    static const double EXACT_POWERS[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    int64_t m;
+    if (digitsAfterPoint > 22 || !value.toInt64(m)) return false;
+    if (m >= (int64_t(1) << 53) || m <= -(int64_t(1) << 53)) return false;
+    result = double(m) / EXACT_POWERS[digitsAfterPoint];
+    return true;
+}
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',' || c == ';' || c == '(' || c == ')';
+}
+
+int parseDecimalLine(const char*& p, const char* last, Decimal* const* targets, int count) {
+    const char* end = std::find(p, last, '\n');
+    const char* comment = std::find(p, end, '#');
+    const char* q = p;
+    p = end == last ? last : end + 1;
+
+    int fields = 0;
+    while (true) {
+        while (q != comment && isBlank(*q)) q++;
+        if (q == comment) return fields;
+        if (fields == count) return -1;
+        const char* next = Decimal::parse(q, comment, *targets[fields]);
+        if (next == nullptr || (next != comment && !isBlank(*next))) return -1;
+        fields++;
+        q = next;
+    }
+}
+
+size_t parseDecimalPoints(const char* first, const char* last, std::vector<DecimalPoint>& points) {
+    size_t line = 0;
+    const char* p = first;
+    while (p != last) {
+        line++;
+        points.emplace_back();
+        Decimal* targets[2] = {&points.back().x, &points.back().y};
+        int fields = parseDecimalLine(p, last, targets, 2);
+        if (fields == 0) {
+            points.pop_back();
+        } else if (fields != 2) {
+            return line;
+        }
+    }
+    return 0;
+}
+
+}
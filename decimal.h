@@ -0,0 +1,64 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include <string>
+#include <vector>
+
+#include "big_number.h"
+
+namespace geom {
+
+// Exact decimal mantissa * 10^-scale with scale >= 0. Arithmetic and comparison
+// align scales first, so "1.5" and "15" differ while "1.50" equals "1.5".
+class Decimal {
+public:
+    Decimal() : digitsAfterPoint(0) {}
+    Decimal(const BigNumber& mantissa, int scale);
+    // Malformed text gives zero; use parse() to detect it.
+    explicit Decimal(const std::string& text);
+
+    // from_chars-style: reads [-+]digits[.digits][(e|E)[-+]digits] starting at
+    // first and returns one past the number, or nullptr when none is there.
+    static const char* parse(const char* first, const char* last, Decimal& value);
+
+    const BigNumber& mantissa() const { return value; }
+    int scale() const { return digitsAfterPoint; }
+    // The same value with scale target >= scale(), as a mantissa.
+    BigNumber scaledMantissa(int target) const;
+
+    int sign() const { return value.sign(); }
+    bool isZero() const { return value.isZero(); }
+    int compare(const Decimal& other) const;
+
+    Decimal add(const Decimal& other) const;
+    Decimal subtract(const Decimal& other) const;
+    Decimal multiply(const Decimal& other) const;
+
+    std::string toString() const;
+    double toDouble() const;
+    // The correctly rounded double when it is cheap to get, i.e. the mantissa is
+    // below 2^53 and the scale at most 22; false otherwise.
+    bool nearestDouble(double& result) const;
+
+private:
+    BigNumber value;
+    int digitsAfterPoint;
+};
+
+struct DecimalPoint {
+    Decimal x, y;
+};
+
+// Reads the numbers of the line starting at p into *targets[0..count) and moves
+// p past the line. Returns how many numbers the line held (0 for blank and
+// comment lines), or -1 for a malformed token or more than count numbers.
+int parseDecimalLine(const char*& p, const char* last, Decimal* const* targets, int count);
+
+// Bulk reader for "x y" lines in the format geom_cli reads: commas, semicolons
+// and parentheses count as blanks, '#' starts a comment and blank lines are
+// skipped. Returns 0, or the 1-based number of the first malformed line.
+size_t parseDecimalPoints(const char* first, const char* last, std::vector<DecimalPoint>& points);
+
+}
+
+#endif
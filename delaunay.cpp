@@ -1,126 +1,111 @@
 #include "delaunay.h"
 
-DelaunayWidget::DelaunayWidget(QWidget *parent) : QWidget(parent), onlineMode(false) {
+// Frames are recycled by the worker, so their vectors keep their capacity and
+// everything else comes from the arena.
+static bool triangulate(const DelaunayRequest& request, DelaunayFrame& frame,
+                        geom::ScratchArena& scratch, const std::atomic<bool>& cancelled) {
+    size_t before = geom::threadAllocations();
+    frame.timing.begin();
+    scratch.reset();
+    frame.preview = request.preview;
+    frame.points = request.points;
+    geom::delaunayTriangulation(request.points.span(), frame.triangles, &scratch, &cancelled);
+    frame.timing.end();
+
+    frame.allocations = request.allocations + geom::threadAllocations() - before;
+    return !cancelled;
+}
+
+DelaunayWidget::DelaunayWidget(QWidget *parent)
+    : QWidget(parent), onlineMode(false),
+      scheduler([this](bool preview) { submitTriangulation(preview); }),
+      worker([this](const DelaunayRequest& request, DelaunayFrame& frame, const std::atomic<bool>& cancelled) {
+                 if (triangulate(request, frame, scratch, cancelled)) return true;
+                 // Superseded full runs never reach frameReady(), so report their time here.
+                 if (!request.preview) {
+                     double ms = frame.timing.elapsedMs();
+                     QMetaObject::invokeMethod(this, [this, ms] { scheduler.reportAbandoned(ms); },
+                                               Qt::QueuedConnection);
+                 }
+                 return false;
+             },
+             [this] { QMetaObject::invokeMethod(this, [this] { frameReady(); }, Qt::QueuedConnection); }) {
     setMouseTracking(true);
     setMinimumSize(800, 600);
 }
 
 void DelaunayWidget::clearPoints() {
     points.clear();
-    triangles.clear();
+    computeDelaunay();
     update();
 }
 
-bool DelaunayWidget::isPointInCircumcircle(const QPointF& a, const QPointF& b, const QPointF& c, const QPointF& p) {
-    double d = 2 * (a.x() * (b.y() - c.y()) +
-                    b.x() * (c.y() - a.y()) +
-                    c.x() * (a.y() - b.y()));
-
-    double ux = ((a.x() * a.x() + a.y() * a.y()) * (b.y() - c.y()) +
-                 (b.x() * b.x() + b.y() * b.y()) * (c.y() - a.y()) +
-                 (c.x() * c.x() + c.y() * c.y()) * (a.y() - b.y())) / d;
-
-    double uy = ((a.x() * a.x() + a.y() * a.y()) * (c.x() - b.x()) +
-                 (b.x() * b.x() + b.y() * b.y()) * (a.x() - c.x()) +
-                 (c.x() * c.x() + c.y() * c.y()) * (b.x() - a.x())) / d;
-
-    QPointF center(ux, uy);
-    double radius = std::sqrt((a.x() - center.x()) * (a.x() - center.x()) +
-                              (a.y() - center.y()) * (a.y() - center.y()));
-
-    double distance = std::sqrt((p.x() - center.x()) * (p.x() - center.x()) +
-                                (p.y() - center.y()) * (p.y() - center.y()));
-
-    return distance <= radius;
-}
-
 void DelaunayWidget::computeDelaunay() {
-    if (points.size() < 3) {
-        triangles.clear();
-        update();
-        return;
-    }
-
-    triangles.clear();
-
-    double minX = points[0].pos.x(), maxX = points[0].pos.x();
-    double minY = points[0].pos.y(), maxY = points[0].pos.y();
+    submitTriangulation(false);
+}
 
-    for (const auto& point : points) {
-        minX = std::min(minX, point.pos.x());
-        maxX = std::max(maxX, point.pos.x());
-        minY = std::min(minY, point.pos.y());
-        maxY = std::max(maxY, point.pos.y());
+// Hands the current coordinates to the worker; a newer call supersedes any
+// triangulation still running, and paintEvent picks up the result.
+void DelaunayWidget::submitTriangulation(bool preview) {
+    size_t before = geom::threadAllocations();
+    DelaunayRequest& request = worker.draft();
+    request.preview = preview;
+    size_t stride = preview ? points.size() / PREVIEW_POINTS + 1 : 1;
+    if (stride == 1) {
+        request.points = points;
+    } else {
+        request.points.clear();
+        request.points.reserve(points.size() / stride + 1);
+        for (size_t i = 0; i < points.size(); i++) {
+            if (i % stride == 0 || points.selected(i)) {
+                request.points.add(points.x(i), points.y(i));
+            }
+        }
     }
 
-    double dx = maxX - minX;
-    double dy = maxY - minY;
-    double deltaMax = std::max(dx, dy);
-    double midX = (minX + maxX) / 2.0;
-    double midY = (minY + maxY) / 2.0;
-
-    int p1 = points.size();
-    int p2 = p1 + 1;
-    int p3 = p1 + 2;
+    request.allocations = geom::threadAllocations() - before;
+    worker.submit();
+}
 
-    std::vector<Triangle> triangleList;
-    triangleList.emplace_back(p1, p2, p3);
+void DelaunayWidget::frameReady() {
+    const DelaunayFrame& frame = worker.latest();
+    if (!frame.preview) scheduler.reportCost(frame.timing.elapsedMs());
+    update();
+}
 
-    std::vector<QPointF> tempPoints;
-    for (const auto& point : points) {
-        tempPoints.push_back(point.pos);
+bool DelaunayWidget::loadScene(const std::string& path, std::string& error) {
+    auto scene = std::make_shared<geom::MappedScene>();
+    if (!scene->open(path, error)) return false;
+    const geom::SceneSection* section = scene->find(geom::SCENE_POINTS);
+    if (!section) {
+        error = path + ": no points";
+        return false;
     }
-    tempPoints.emplace_back(midX - 20 * deltaMax, midY - deltaMax);
-    tempPoints.emplace_back(midX, midY + 20 * deltaMax);
-    tempPoints.emplace_back(midX + 20 * deltaMax, midY - deltaMax);
-
-    for (int i = 0; i < points.size(); i++) {
-        std::vector<Edge> polygon;
-        std::vector<Triangle> toRemove;
-
-        for (const auto& triangle : triangleList) {
-            if (isPointInCircumcircle(tempPoints[triangle.p1],
-                                      tempPoints[triangle.p2],
-                                      tempPoints[triangle.p3],
-                                      points[i].pos)) {
-                toRemove.push_back(triangle);
-
-                polygon.emplace_back(triangle.p1, triangle.p2);
-                polygon.emplace_back(triangle.p2, triangle.p3);
-                polygon.emplace_back(triangle.p3, triangle.p1);
-            }
-        }
 
-        for (const auto& triangle : toRemove) {
-            triangleList.erase(
-                std::remove(triangleList.begin(), triangleList.end(), triangle),
-                triangleList.end()
-                );
-        }
-
-        std::vector<Edge> uniqueEdges;
-        for (const auto& edge : polygon) {
-            int count = std::count(polygon.begin(), polygon.end(), edge);
-            if (count == 1) {
-                uniqueEdges.push_back(edge);
-            }
-        }
+    // The points stay in the mapping until the first edit.
+    points.view(scene->xs(*section), scene->ys(*section), size_t(section->count), scene);
+    computeDelaunay();
+    update();
+    return true;
+}
 
-        for (const auto& edge : uniqueEdges) {
-            triangleList.emplace_back(edge.p1, edge.p2, i);
-        }
-    }
+bool DelaunayWidget::saveScene(const std::string& path, std::string& error) {
 
-    for (auto it = triangleList.begin(); it != triangleList.end();) {
-        if (it->p1 >= points.size() || it->p2 >= points.size() || it->p3 >= points.size()) {
-            it = triangleList.erase(it);
-        } else {
-            ++it;
+    std::vector<uint32_t> indices;
+    const DelaunayFrame& frame = worker.latest();
+    if (!frame.preview && frame.points.size() == points.size()) {
+        indices.reserve(3 * frame.triangles.size());
+        for (const auto& triangle : frame.triangles) {
+            indices.push_back(uint32_t(triangle.p1));
+            indices.push_back(uint32_t(triangle.p2));
+            indices.push_back(uint32_t(triangle.p3));
         }
     }
 
-    triangles = triangleList;
-    update();
+    geom::SceneWriter writer;
+    writer.addPoints(points.xs(), points.ys(), points.size());
+    if (!indices.empty()) writer.addTriangles(indices.data(), indices.size() / 3);
+    return writer.write(path, error);
 }
 
 void DelaunayWidget::paintEvent(QPaintEvent *event) {
@@ -131,56 +116,62 @@ void DelaunayWidget::paintEvent(QPaintEvent *event) {
 
     painter.fillRect(rect(), Qt::white);
 
+    const DelaunayFrame& frame = worker.latest();
+    auto corner = [&frame](int index) { return QPointF(frame.points.x(index), frame.points.y(index)); };
+    const std::vector<Triangle>& triangles = frame.triangles;
+
     if (!triangles.empty()) {
         painter.setPen(QPen(Qt::blue, 1));
         painter.setBrush(QBrush(QColor(200, 200, 255, 100)));
 
         for (const auto& triangle : triangles) {
             QPolygonF polygon;
-            polygon << points[triangle.p1].pos
-                    << points[triangle.p2].pos
-                    << points[triangle.p3].pos;
+            polygon << corner(triangle.p1)
+                    << corner(triangle.p2)
+                    << corner(triangle.p3);
             painter.drawPolygon(polygon);
         }
     }
 
     painter.setPen(Qt::black);
     painter.setBrush(Qt::red);
-    for (const auto& point : points) {
-        painter.drawEllipse(point.pos, 4, 4);
+    for (size_t i = 0; i < points.size(); i++) {
+        painter.drawEllipse(QPointF(points.x(i), points.y(i)), 4, 4);
     }
 
     painter.setPen(QPen(Qt::darkBlue, 2));
     for (const auto& triangle : triangles) {
-        painter.drawLine(points[triangle.p1].pos, points[triangle.p2].pos);
-        painter.drawLine(points[triangle.p2].pos, points[triangle.p3].pos);
-        painter.drawLine(points[triangle.p3].pos, points[triangle.p1].pos);
+        painter.drawLine(corner(triangle.p1), corner(triangle.p2));
+        painter.drawLine(corner(triangle.p2), corner(triangle.p3));
+        painter.drawLine(corner(triangle.p3), corner(triangle.p1));
     }
 
     painter.setPen(Qt::black);
     painter.drawText(10, 20, QString("Точек: %1").arg(points.size()));
     painter.drawText(10, 40, QString("Треугольников: %1").arg(triangles.size()));
     painter.drawText(10, 60, onlineMode ? "Режим: Онлайн" : "Режим: Обычный");
+    painter.drawText(10, 80, QString("Выделений памяти: %1").arg(geom::allocationsCounted() ? QString::number(frame.allocations) : QString("н/д")));
+    if (frame.preview) painter.drawText(10, 100, "Предпросмотр");
+
+    frame.timing.paint(painter, rect());
 }
 
 void DelaunayWidget::mousePressEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton) {
         QPointF pos = event->position();
 
-        for (auto& point : points) {
-            QPointF diff = point.pos - pos;
-            if (diff.x() * diff.x() + diff.y() * diff.y() <= 100) {
-                point.isDragging = true;
-                if (onlineMode) {
-                    computeDelaunay();
-                }
-                return;
+        size_t hit = points.findWithin(pos.x(), pos.y(), 100);
+        if (hit < points.size()) {
+            points.select(hit);
+            if (onlineMode) {
+                scheduler.markDirty();
             }
+            return;
         }
 
-        points.emplace_back(pos);
+        points.add(pos.x(), pos.y());
         if (onlineMode) {
-            computeDelaunay();
+            scheduler.markDirty();
         }
         update();
     }
@@ -190,25 +181,23 @@ void DelaunayWidget::mouseMoveEvent(QMouseEvent *event) {
     if (event->buttons() & Qt::LeftButton) {
         QPointF pos = event->position();
 
-        for (auto& point : points) {
-            if (point.isDragging) {
-                point.pos = pos;
-                if (onlineMode) {
-                    computeDelaunay();
-                }
-                update();
-                return;
+        size_t dragged = points.firstSelected();
+        if (dragged < points.size()) {
+            points.set(dragged, pos.x(), pos.y());
+            if (onlineMode) {
+                scheduler.markDirty();
             }
+            update();
         }
     }
 }
 
 void DelaunayWidget::mouseReleaseEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton) {
-        for (auto& point : points) {
-            point.isDragging = false;
-        }
-        if (!onlineMode) {
+        points.clearSelection();
+        if (onlineMode) {
+            scheduler.flush();
+        } else {
             computeDelaunay();
         }
         update();
@@ -233,11 +222,15 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
 
     QPushButton *clearButton = new QPushButton("Очистить", this);
     QPushButton *computeButton = new QPushButton("Триангуляция Делоне", this);
+    QPushButton *openButton = new QPushButton("Открыть сцену", this);
+    QPushButton *saveButton = new QPushButton("Сохранить сцену", this);
     QCheckBox *onlineCheckbox = new QCheckBox("Онлайн режим", this);
     QLabel *infoLabel = new QLabel("ЛКМ: добавить точку | Перетащить: двигать точку", this);
 
     controlLayout->addWidget(clearButton);
     controlLayout->addWidget(computeButton);
+    controlLayout->addWidget(openButton);
+    controlLayout->addWidget(saveButton);
     controlLayout->addWidget(onlineCheckbox);
     controlLayout->addWidget(infoLabel);
     controlLayout->addStretch();
@@ -247,6 +240,20 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
     connect(clearButton, &QPushButton::clicked, delaunayWidget, &DelaunayWidget::clearPoints);
     connect(computeButton, &QPushButton::clicked, delaunayWidget, &DelaunayWidget::computeDelaunay);
     connect(onlineCheckbox, &QCheckBox::toggled, delaunayWidget, &DelaunayWidget::setOnlineMode);
+    connect(openButton, &QPushButton::clicked, this, [this] {
+        QString path = QFileDialog::getOpenFileName(this, "Открыть сцену", QString(), "Scenes (*.scene);;All files (*)");
+        std::string error;
+        if (!path.isEmpty() && !delaunayWidget->loadScene(path.toLocal8Bit().constData(), error)) {
+            QMessageBox::warning(this, "Ошибка", QString::fromStdString(error));
+        }
+    });
+    connect(saveButton, &QPushButton::clicked, this, [this] {
+        QString path = QFileDialog::getSaveFileName(this, "Сохранить сцену", QString(), "Scenes (*.scene)");
+        std::string error;
+        if (!path.isEmpty() && !delaunayWidget->saveScene(path.toLocal8Bit().constData(), error)) {
+            QMessageBox::warning(this, "Ошибка", QString::fromStdString(error));
+        }
+    });
 
     setWindowTitle("Триангуляция Делоне");
     resize(900, 700);
@@ -10,36 +10,42 @@
 #include <QPushButton>
 #include <QCheckBox>
 #include <QLabel>
+#include <QFileDialog>
+#include <QMessageBox>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <set>
+#include <string>
 
-class Point {
-public:
-    QPointF pos;
-    bool isDragging = false;
-    Point(const QPointF& p) : pos(p) {}
-};
+#include "delaunay_core.h"
+#include "point_set.h"
+#include "trace_overlay.h"
+#include "latest_worker.h"
+#include "frame_scheduler.h"
+#include "scratch_arena.h"
+#include "scene_file.h"
+#include "alloc_counter.h"
 
-struct Triangle {
-    int p1, p2, p3;
-    Triangle(int a, int b, int c) : p1(a), p2(b), p3(c) {}
-    bool operator==(const Triangle& other) const {
-        return p1 == other.p1 && p2 == other.p2 && p3 == other.p3;
-    }
+using geom::Triangle;
+
+struct DelaunayRequest {
+    geom::PointSet points;
+    bool preview = false;
+    // Heap allocations made while filling it on the GUI thread.
+    size_t allocations = 0;
 };
 
-struct Edge {
-    int p1, p2;
-    Edge(int a, int b) : p1(std::min(a, b)), p2(std::max(a, b)) {}
-    bool operator==(const Edge& other) const {
-        return p1 == other.p1 && p2 == other.p2;
-    }
-    bool operator<(const Edge& other) const {
-        if (p1 != other.p1) return p1 < other.p1;
-        return p2 < other.p2;
-    }
+// A finished triangulation together with the coordinates it was built from,
+// so it can be drawn while the points keep moving.
+struct DelaunayFrame {
+    geom::PointSet points;
+    std::vector<Triangle> triangles;
+    bool preview = false;
+    // Heap allocations for the request and the run, counted by operator new;
+    // zero once buffers have warmed up.
+    size_t allocations = 0;
+    TraceOverlay timing;
 };
 
 class DelaunayWidget : public QWidget {
@@ -49,6 +55,10 @@ public:
     DelaunayWidget(QWidget *parent = nullptr);
     void clearPoints();
     void computeDelaunay();
+    // Points come from the first point section and are triangulated afresh;
+    // saving adds the triangles when the shown triangulation is complete.
+    bool loadScene(const std::string& path, std::string& error);
+    bool saveScene(const std::string& path, std::string& error);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -57,11 +67,21 @@ protected:
     void mouseReleaseEvent(QMouseEvent *event) override;
 
 private:
-    std::vector<Point> points;
-    std::vector<Triangle> triangles;
-    bool onlineMode;
+    // Preview triangulations use every k-th point, at most this many, plus
+    // dragged ones; insertion is quadratic, so this stays well inside a frame.
+    static const size_t PREVIEW_POINTS = 300;
 
-    bool isPointInCircumcircle(const QPointF& a, const QPointF& b, const QPointF& c, const QPointF& p);
+    void submitTriangulation(bool preview);
+    void frameReady();
+
+    // Dragged points are the selected ones.
+    geom::PointSet points;
+    bool onlineMode;
+    FrameScheduler scheduler;
+    // Temporaries of the triangulation; used by the worker thread only.
+    geom::ScratchArena scratch;
+    // Destroyed first, so the worker thread is joined while the widget is intact.
+    geom::LatestWinsWorker<DelaunayRequest, DelaunayFrame> worker;
 
 public slots:
     void setOnlineMode(bool enabled);
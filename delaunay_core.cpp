@@ -0,0 +1,58 @@
+#include "delaunay_core.h"
+
+#include <cmath>
+
+namespace geom {
+
+bool isPointInCircumcircle(const Point& a, const Point& b, const Point& c, const Point& p) {
+    double d = 2 * (a.x * (b.y - c.y) +
+                    b.x * (c.y - a.y) +
+                    c.x * (a.y - b.y));
+
+    double ux = ((a.x * a.x + a.y * a.y) * (b.y - c.y) +
+                 (b.x * b.x + b.y * b.y) * (c.y - a.y) +
+                 (c.x * c.x + c.y * c.y) * (a.y - b.y)) / d;
+
+    double uy = ((a.x * a.x + a.y * a.y) * (c.x - b.x) +
+                 (b.x * b.x + b.y * b.y) * (a.x - c.x) +
+                 (c.x * c.x + c.y * c.y) * (b.x - a.x)) / d;
+
+    Point center(ux, uy);
+    double radius = std::sqrt((a.x - center.x) * (a.x - center.x) +
+                              (a.y - center.y) * (a.y - center.y));
+
+    double distance = std::sqrt((p.x - center.x) * (p.x - center.x) +
+                                (p.y - center.y) * (p.y - center.y));
+
+    return distance <= radius;
+}
+
+std::vector<Triangle> delaunayTriangulation(const std::vector<Point>& points,
+                                            const std::atomic<bool>* cancel) {
+    std::vector<Triangle> triangles;
+    delaunayTriangulation(points, triangles, std::pmr::new_delete_resource(), cancel);
+    return triangles;
+}
+
+void delaunayTriangulation(const std::vector<Point>& points, std::vector<Triangle>& triangles,
+                           std::pmr::memory_resource* scratch, const std::atomic<bool>* cancel) {
+    delaunayTriangulation(spanOf(points), triangles, scratch, cancel);
+}
+
+// Every supported coordinate type, so the library build checks them all.
+template void delaunayTriangulation(const PointSpan<BasicPoint<float>>&, std::vector<Triangle>&,
+                                    std::pmr::memory_resource*, const std::atomic<bool>*);
+template void delaunayTriangulation(const PointSpan<IntPoint>&, std::vector<Triangle>&,
+                                    std::pmr::memory_resource*, const std::atomic<bool>*);
+template void delaunayTriangulation(const PointSpan<BasicPoint<int64_t>>&, std::vector<Triangle>&,
+                                    std::pmr::memory_resource*, const std::atomic<bool>*);
+template void delaunayTriangulation(const CoordinateSpan<float>&, std::vector<Triangle>&,
+                                    std::pmr::memory_resource*, const std::atomic<bool>*);
+template void delaunayTriangulation(const CoordinateSpan<double>&, std::vector<Triangle>&,
+                                    std::pmr::memory_resource*, const std::atomic<bool>*);
+template void delaunayTriangulation(const CoordinateSpan<int32_t>&, std::vector<Triangle>&,
+                                    std::pmr::memory_resource*, const std::atomic<bool>*);
+template void delaunayTriangulation(const CoordinateSpan<int64_t>&, std::vector<Triangle>&,
+                                    std::pmr::memory_resource*, const std::atomic<bool>*);
+
+}
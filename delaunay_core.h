@@ -0,0 +1,198 @@
+#ifndef DELAUNAY_CORE_H
+#define DELAUNAY_CORE_H
+
+#include <atomic>
+#include <limits>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+
+#include "geometry.h"
+#include "fixed_int.h"
+#include "point_traits.h"
+#include "trace.h"
+
+namespace geom {
+
+struct Triangle {
+    int p1, p2, p3;
+    Triangle(int a, int b, int c) : p1(a), p2(b), p3(c) {}
+    bool operator==(const Triangle& other) const {
+        return p1 == other.p1 && p2 == other.p2 && p3 == other.p3;
+    }
+};
+
+struct Edge {
+    int p1, p2;
+    Edge(int a, int b) : p1(std::min(a, b)), p2(std::max(a, b)) {}
+    bool operator==(const Edge& other) const {
+        return p1 == other.p1 && p2 == other.p2;
+    }
+    bool operator<(const Edge& other) const {
+        if (p1 != other.p1) return p1 < other.p1;
+        return p2 < other.p2;
+    }
+};
+
+bool isPointInCircumcircle(const Point& a, const Point& b, const Point& c, const Point& p);
+
+// Bowyer-Watson insertion; triangle corners index into points. When cancel is
+// raised the triangulation stops before the next insertion and returns nothing.
+std::vector<Triangle> delaunayTriangulation(const std::vector<Point>& points,
+                                            const std::atomic<bool>* cancel = nullptr);
+// Same, reusing the capacity of triangles and taking every temporary from
+// scratch, e.g. a ScratchArena reset between runs.
+void delaunayTriangulation(const std::vector<Point>& points, std::vector<Triangle>& triangles,
+                           std::pmr::memory_resource* scratch, const std::atomic<bool>* cancel = nullptr);
+
+// Inside or on the circle through a, b, c, decided exactly with the
+// fixed-width predicates for coordinates of InputBits signed bits; false for
+// collinear a, b, c.
+template<int InputBits, typename P>
+bool exactInCircumcircle(const P& a, const P& b, const P& c, const P& p) {
+    int orientation = orient2dSign<InputBits>(a.x, a.y, b.x, b.y, c.x, c.y);
+    return orientation != 0 && incircleSign<InputBits>(a.x, a.y, b.x, b.y, c.x, c.y, p.x, p.y) * orientation >= 0;
+}
+
+// Vertex type and circumcircle test of the triangulation for a coordinate
+// type. Floating coordinates use the double test.
+template<typename Scalar, bool Integral = std::is_integral<Scalar>::value>
+struct DelaunayKernel {
+    typedef Point Vertex;
+    static bool inCircumcircle(const Vertex& a, const Vertex& b, const Vertex& c, const Vertex& p) {
+        return isPointInCircumcircle(a, b, c, p);
+    }
+};
+
+// Integer coordinates are widened to int64 and tested exactly. The super
+// triangle reaches 20 bounding boxes out, which takes up to 6 more bits, so
+// int32 sources may use their whole range and int64 ones must stay below
+// 2^55 in magnitude.
+template<typename Scalar>
+struct DelaunayKernel<Scalar, true> {
+    typedef BasicPoint<int64_t> Vertex;
+    static constexpr int BITS = std::numeric_limits<Scalar>::digits + 7 < 62
+                                ? std::numeric_limits<Scalar>::digits + 7 : 62;
+    static bool inCircumcircle(const Vertex& a, const Vertex& b, const Vertex& c, const Vertex& p) {
+        return exactInCircumcircle<BITS>(a, b, c, p);
+    }
+};
+
+// Same over any point source from point_traits.h, read in place; see
+// DelaunayKernel for how each coordinate type is tested.
+template<typename Source>
+void delaunayTriangulation(const Source& points, std::vector<Triangle>& triangles,
+                           std::pmr::memory_resource* scratch, const std::atomic<bool>* cancel = nullptr) {
+    typedef DelaunayKernel<typename Source::Scalar> Kernel;
+    typedef typename Kernel::Vertex Vertex;
+    typedef decltype(Vertex::x) Coordinate;
+
+    triangles.clear();
+    if (points.size() < 3) return;
+
+    TraceScope prefilter("delaunay.prefilter");
+    int n = points.size();
+    Coordinate minX = Coordinate(points.x(0)), maxX = minX;
+    Coordinate minY = Coordinate(points.y(0)), maxY = minY;
+
+    for (int i = 1; i < n; i++) {
+        minX = std::min(minX, Coordinate(points.x(i)));
+        maxX = std::max(maxX, Coordinate(points.x(i)));
+        minY = std::min(minY, Coordinate(points.y(i)));
+        maxY = std::max(maxY, Coordinate(points.y(i)));
+    }
+
+    Coordinate dx = maxX - minX;
+    Coordinate dy = maxY - minY;
+    Coordinate deltaMax = std::max(dx, dy);
+    Coordinate midX = (minX + maxX) / 2;
+    Coordinate midY = (minY + maxY) / 2;
+
+    int p1 = n;
+    int p2 = p1 + 1;
+    int p3 = p1 + 2;
+
+    std::pmr::vector<Triangle> triangleList(scratch);
+    triangleList.emplace_back(p1, p2, p3);
+
+    // Indices n, n + 1 and n + 2 are the super triangle; the input is read in place.
+    const Vertex super[3] = {Vertex(midX - 20 * deltaMax, midY - deltaMax),
+                             Vertex(midX, midY + 20 * deltaMax),
+                             Vertex(midX + 20 * deltaMax, midY - deltaMax)};
+    auto vertex = [&](int index) {
+        return index < n ? Vertex(Coordinate(points.x(index)), Coordinate(points.y(index))) : super[index - n];
+    };
+    prefilter.end();
+
+    // Every live triangle gets one incircle test per insertion.
+    int64_t incircleTests = 0;
+    int64_t cavityTriangles = 0;
+    int64_t boundaryEdges = 0;
+
+    // Reused by every insertion, so they only grow while the cavity does.
+    std::pmr::vector<Edge> polygon(scratch);
+    std::pmr::vector<Triangle> toRemove(scratch);
+    std::pmr::vector<Edge> uniqueEdges(scratch);
+
+    TraceScope insert("delaunay.insert");
+    for (int i = 0; i < n; i++) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return;
+
+        polygon.clear();
+        toRemove.clear();
+        uniqueEdges.clear();
+
+        TraceScope cavity("delaunay.cavity");
+        incircleTests += int64_t(triangleList.size());
+        for (const auto& triangle : triangleList) {
+            if (Kernel::inCircumcircle(vertex(triangle.p1),
+                                       vertex(triangle.p2),
+                                       vertex(triangle.p3),
+                                       vertex(i))) {
+                toRemove.push_back(triangle);
+
+                polygon.emplace_back(triangle.p1, triangle.p2);
+                polygon.emplace_back(triangle.p2, triangle.p3);
+                polygon.emplace_back(triangle.p3, triangle.p1);
+            }
+        }
+
+        for (const auto& triangle : toRemove) {
+            triangleList.erase(
+                std::remove(triangleList.begin(), triangleList.end(), triangle),
+                triangleList.end()
+                );
+        }
+        cavity.end();
+        cavityTriangles += int64_t(toRemove.size());
+
+        for (const auto& edge : polygon) {
+            int count = std::count(polygon.begin(), polygon.end(), edge);
+            if (count == 1) {
+                uniqueEdges.push_back(edge);
+            }
+        }
+
+        boundaryEdges += int64_t(uniqueEdges.size());
+        for (const auto& edge : uniqueEdges) {
+            triangleList.emplace_back(edge.p1, edge.p2, i);
+        }
+    }
+    insert.end();
+    traceCounter("delaunay.incircle_tests", incircleTests);
+    traceCounter("delaunay.cavity_triangles", cavityTriangles);
+    traceCounter("delaunay.boundary_edges", boundaryEdges);
+
+    TraceScope cleanup("delaunay.cleanup");
+    for (const auto& triangle : triangleList) {
+        if (triangle.p1 < n && triangle.p2 < n && triangle.p3 < n) {
+            triangles.push_back(triangle);
+        }
+    }
+}
+
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Regression test for the integer Delaunay path: near-cocircular grids far
+// from the origin, where the double circumcircle test used to give overlapping
+// and degenerate triangles. Every triangle is checked against every point with
+// an incircle determinant evaluated on BigNumber, independent of fixed_int.h.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "big_number.h"
+#include "delaunay_core.h"
+#include "scratch_arena.h"
+
+using namespace geom;
+
+static BigNumber big(int64_t value) {
+    return BigNumber(std::to_string(value));
+}
+
+static int orientSign(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t cx, int64_t cy) {
+    return big(bx - ax).multiply(big(cy - ay)).subtract(big(by - ay).multiply(big(cx - ax))).sign();
+}
+
+// Positive when d is inside the circle through a, b, c in counter-clockwise order.
+static int incircle(int64_t ax, int64_t ay, int64_t bx, int64_t by,
+                    int64_t cx, int64_t cy, int64_t dx, int64_t dy) {
+    BigNumber adx = big(ax - dx), ady = big(ay - dy);
+    BigNumber bdx = big(bx - dx), bdy = big(by - dy);
+    BigNumber cdx = big(cx - dx), cdy = big(cy - dy);
+    BigNumber alift = adx.multiply(adx).add(ady.multiply(ady));
+    BigNumber blift = bdx.multiply(bdx).add(bdy.multiply(bdy));
+    BigNumber clift = cdx.multiply(cdx).add(cdy.multiply(cdy));
+    BigNumber det = alift.multiply(bdx.multiply(cdy).subtract(cdx.multiply(bdy)));
+    det += blift.multiply(cdx.multiply(ady).subtract(adx.multiply(cdy)));
+    det += clift.multiply(adx.multiply(bdy).subtract(bdx.multiply(ady)));
+    return det.sign();
+}
+
+// Returns the number of violations: degenerate triangles, more triangles than a
+// triangulation of n points can have, and points strictly inside a circumcircle.
+template<typename T>
+static int check(const char* name, const std::vector<T>& xs, const std::vector<T>& ys) {
+    ScratchArena scratch;
+    std::vector<Triangle> triangles;
+    delaunayTriangulation(CoordinateSpan<T>(xs.data(), ys.data(), xs.size()), triangles, &scratch);
+
+    int degenerate = 0, inside = 0;
+    for (const Triangle& t : triangles) {
+        int orientation = orientSign(xs[t.p1], ys[t.p1], xs[t.p2], ys[t.p2], xs[t.p3], ys[t.p3]);
+        if (orientation == 0) {
+            degenerate++;
+            continue;
+        }
+        for (size_t i = 0; i < xs.size(); i++) {
+            int side = incircle(xs[t.p1], ys[t.p1], xs[t.p2], ys[t.p2], xs[t.p3], ys[t.p3], xs[i], ys[i]);
+            if (side * orientation > 0) inside++;
+        }
+    }
+
+    size_t limit = 2 * xs.size() - 5;
+    int excess = triangles.size() > limit ? 1 : 0;
+    int failures = degenerate + inside + excess;
+    std::printf("%-28s %4zu points %4zu triangles, %d degenerate, %d inside%s\n", name, xs.size(),
+                triangles.size(), degenerate, inside, excess ? ", too many triangles" : "");
+    return failures;
+}
+
+// side x side grid at (offset, offset) with the given spacing; jitter moves
+// every point by up to that much, so the cells are only nearly cocircular.
+template<typename T>
+static int grid(const char* name, int64_t offset, int64_t spacing, int jitter, std::mt19937& rng) {
+    const int side = 8;
+    std::vector<T> xs, ys;
+    std::uniform_int_distribution<int> shift(-jitter, jitter);
+    for (int i = 0; i < side; i++) {
+        for (int j = 0; j < side; j++) {
+            xs.push_back(T(offset + i * spacing + shift(rng)));
+            ys.push_back(T(offset + j * spacing + shift(rng)));
+        }
+    }
+    return check(name, xs, ys);
+}
+
+int main() {
+    std::mt19937 rng(49);
+    int failures = 0;
+    failures += grid<int32_t>("int32 exact grid at 1e9", 1000000000, 1, 0, rng);
+    failures += grid<int32_t>("int32 near grid at 1e9", 1000000000, 3, 1, rng);
+    failures += grid<int32_t>("int32 near grid at 1e8", 100000000, 1, 1, rng);
+    failures += grid<int32_t>("int32 near grid at -2e9", -2000000000, 1000, 1, rng);
+    failures += grid<int64_t>("int64 near grid at 1e15", 1000000000000000LL, 3, 1, rng);
+
+    if (failures) {
+        std::printf("FAILED: %d violations\n", failures);
+        return 1;
+    }
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,176 @@
+#ifndef FIXED_INT_H
+#define FIXED_INT_H
+
+#include <cstdint>
+
+namespace geom {
+
+// Two's complement integer on a fixed number of 64-bit limbs, wide enough for
+// Bits signed bits. Everything lives in the object and every loop has a
+// compile-time trip count, so predicates built on it unroll completely.
+// Arithmetic widens the result type the way the bit counts grow (a sum of A- and
+// B-bit values has max(A, B) + 1 bits, a product A + B), so small factors stay
+// on one or two limbs and only the final terms use the full width.
+template<int Bits>
+class FixedInt {
+public:
+    static_assert(Bits > 0, "FixedInt needs at least one bit");
+    static constexpr int LIMBS = (Bits + 63) / 64;
+
+    uint64_t limb[LIMBS];
+
+    constexpr FixedInt() : limb{} {}
+    constexpr FixedInt(int64_t value) : limb{} {
+        limb[0] = uint64_t(value);
+        for (int i = 1; i < LIMBS; i++) limb[i] = uint64_t(value >> 63);
+    }
+
+    // Sign-extends a narrower value.
+    template<int Other>
+    constexpr FixedInt(const FixedInt<Other>& other) : limb{} {
+        static_assert(Other <= Bits, "FixedInt conversions only widen");
+        for (int i = 0; i < FixedInt<Other>::LIMBS; i++) limb[i] = other.limb[i];
+        uint64_t fill = uint64_t(int64_t(other.limb[FixedInt<Other>::LIMBS - 1]) >> 63);
+        for (int i = FixedInt<Other>::LIMBS; i < LIMBS; i++) limb[i] = fill;
+    }
+
+    // Values of at most two limbs (LIMBS <= 2) go through native 128-bit integers.
+    constexpr __int128 toInt128() const {
+        if (LIMBS == 1) return int64_t(limb[0]);
+        return __int128(((unsigned __int128)limb[LIMBS - 1] << 64) | limb[0]);
+    }
+
+    static constexpr FixedInt fromInt128(__int128 value) {
+        FixedInt res;
+        res.limb[0] = uint64_t(value);
+        if (LIMBS > 1) res.limb[LIMBS > 1 ? 1 : 0] = uint64_t(value >> 64);
+        for (int i = 2; i < LIMBS; i++) res.limb[i] = uint64_t(value >> 127);
+        return res;
+    }
+
+    // Branch-free: predicate signs are close to random, so branches mispredict.
+    constexpr int sign() const {
+        uint64_t any = 0;
+        for (int i = 0; i < LIMBS; i++) any |= limb[i];
+        return int(any != 0) - 2 * int(limb[LIMBS - 1] >> 63);
+    }
+
+    constexpr bool operator==(const FixedInt& other) const {
+        for (int i = 0; i < LIMBS; i++) {
+            if (limb[i] != other.limb[i]) return false;
+        }
+        return true;
+    }
+};
+
+constexpr int maxBits(int a, int b) { return a > b ? a : b; }
+
+template<int A, int B>
+constexpr FixedInt<maxBits(A, B) + 1> operator+(const FixedInt<A>& a, const FixedInt<B>& b) {
+    typedef FixedInt<maxBits(A, B) + 1> Result;
+    Result x(a), y(b), res;
+    if (Result::LIMBS <= 2) {
+        return Result::fromInt128(__int128((unsigned __int128)x.toInt128() + (unsigned __int128)y.toInt128()));
+    }
+    uint64_t carry = 0;
+    for (int i = 0; i < Result::LIMBS; i++) {
+        unsigned __int128 sum = (unsigned __int128)x.limb[i] + y.limb[i] + carry;
+        res.limb[i] = uint64_t(sum);
+        carry = uint64_t(sum >> 64);
+    }
+    return res;
+}
+
+template<int A, int B>
+constexpr FixedInt<maxBits(A, B) + 1> operator-(const FixedInt<A>& a, const FixedInt<B>& b) {
+    typedef FixedInt<maxBits(A, B) + 1> Result;
+    Result x(a), y(b), res;
+    if (Result::LIMBS <= 2) {
+        return Result::fromInt128(__int128((unsigned __int128)x.toInt128() - (unsigned __int128)y.toInt128()));
+    }
+    uint64_t borrow = 0;
+    for (int i = 0; i < Result::LIMBS; i++) {
+        unsigned __int128 diff = (unsigned __int128)x.limb[i] - y.limb[i] - borrow;
+        res.limb[i] = uint64_t(diff);
+        borrow = uint64_t(diff >> 64);
+    }
+    return res;
+}
+
+// Multiplies the limbs as unsigned and then corrects for negative operands:
+// with a = x - [a < 0] 2^(64 LA), a * b = x * y - [a < 0] y 2^(64 LA)
+// - [b < 0] x 2^(64 LB) modulo 2^(64 (LA + LB)). Sign-extension limbs are never
+// multiplied.
+template<int A, int B>
+constexpr FixedInt<A + B> operator*(const FixedInt<A>& a, const FixedInt<B>& b) {
+    typedef FixedInt<A + B> Result;
+    const int LA = FixedInt<A>::LIMBS, LB = FixedInt<B>::LIMBS;
+    if (LA == 1 && LB == 1) {
+        return Result::fromInt128(__int128(int64_t(a.limb[0])) * int64_t(b.limb[0]));
+    }
+
+    Result res;
+    for (int i = 0; i < LA; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < LB && i + j < Result::LIMBS; j++) {
+            unsigned __int128 product = (unsigned __int128)a.limb[i] * b.limb[j] +
+                                        res.limb[i + j] + carry;
+            res.limb[i + j] = uint64_t(product);
+            carry = uint64_t(product >> 64);
+        }
+        if (i + LB < Result::LIMBS) res.limb[i + LB] = carry;
+    }
+
+    uint64_t maskA = uint64_t(int64_t(a.limb[LA - 1]) >> 63);
+    uint64_t maskB = uint64_t(int64_t(b.limb[LB - 1]) >> 63);
+    uint64_t borrow = 0;
+    for (int i = LA; i < Result::LIMBS; i++) {
+        unsigned __int128 diff = (unsigned __int128)res.limb[i] - (i - LA < LB ? b.limb[i - LA] & maskA : 0) - borrow;
+        res.limb[i] = uint64_t(diff);
+        borrow = uint64_t(diff >> 64) & 1;
+    }
+    borrow = 0;
+    for (int i = LB; i < Result::LIMBS; i++) {
+        unsigned __int128 diff = (unsigned __int128)res.limb[i] - (i - LB < LA ? a.limb[i - LB] & maskB : 0) - borrow;
+        res.limb[i] = uint64_t(diff);
+        borrow = uint64_t(diff >> 64) & 1;
+    }
+    return res;
+}
+
+// Exact orient2d and incircle signs for coordinates of InputBits signed bits.
+// Coordinate differences take InputBits + 1 bits, so orient2d needs
+// 2 * InputBits + 2 bits and the lifted incircle determinant 4 * InputBits + 5.
+template<int InputBits>
+constexpr int orient2dSign(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t cx, int64_t cy) {
+    static_assert(InputBits <= 62, "coordinate differences must fit int64");
+    typedef FixedInt<InputBits + 1> Difference;
+    auto det = Difference(bx - ax) * Difference(cy - ay) - Difference(by - ay) * Difference(cx - ax);
+    static_assert(decltype(det)::LIMBS * 64 >= 2 * InputBits + 2, "orient2d width");
+    return det.sign();
+}
+
+// Positive when d lies inside the circle through a, b, c in counter-clockwise
+// order, negative outside and zero on it; the sign flips for clockwise a, b, c.
+template<int InputBits>
+constexpr int incircleSign(int64_t ax, int64_t ay, int64_t bx, int64_t by,
+                           int64_t cx, int64_t cy, int64_t dx, int64_t dy) {
+    static_assert(InputBits <= 62, "coordinate differences must fit int64");
+    typedef FixedInt<InputBits + 1> Difference;
+    Difference adx(ax - dx), ady(ay - dy);
+    Difference bdx(bx - dx), bdy(by - dy);
+    Difference cdx(cx - dx), cdy(cy - dy);
+
+    auto alift = adx * adx + ady * ady;
+    auto blift = bdx * bdx + bdy * bdy;
+    auto clift = cdx * cdx + cdy * cdy;
+
+    auto det = alift * (bdx * cdy - cdx * bdy) +
+               blift * (cdx * ady - adx * cdy) +
+               clift * (adx * bdy - bdx * ady);
+    return det.sign();
+}
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <algorithm>
+#include <functional>
+
+// Coalesces change notifications into at most one recompute per frame
+// interval. While the last full recompute took longer than the interval, the
+// callback is asked for a cheaper preview instead; flush() runs a full one.
+//
+// Synchronous callers are timed here. Widgets that compute on a worker call
+// reportCost() with the worker's time instead, which turns the timing off, and
+// reportAbandoned() for full runs a newer request cancelled.
+class FrameScheduler {
+public:
+    typedef std::function<void(bool preview)> Recompute;
+
+    explicit FrameScheduler(Recompute recompute, int intervalMs = 16)
+        : recompute(std::move(recompute)), intervalMs(intervalMs) {
+        timer.setSingleShot(true);
+        timer.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&timer, &QTimer::timeout, &timer, [this] { run(false); });
+        sinceLast.start();
+    }
+
+    void setInterval(int ms) { intervalMs = ms; }
+    int interval() const { return intervalMs; }
+    bool previewing() const { return overran || fullCostMs > intervalMs; }
+
+    // Recomputes at the next frame boundary; further calls until then are free.
+    void markDirty() {
+        dirty = true;
+        if (timer.isActive()) return;
+        qint64 wait = intervalMs - sinceLast.elapsed();
+        timer.start(wait > 0 ? int(wait) : 0);
+    }
+
+    // Full recompute now if anything is pending or the screen shows a preview.
+    void flush() {
+        timer.stop();
+        if (dirty || lastWasPreview) run(true);
+    }
+
+    void reportCost(double ms) {
+        costReported = true;
+        fullCostMs = ms;
+        overran = false;
+    }
+
+    // A full run superseded before it finished cost at least ms and did not
+    // fit in a frame, so previews start without waiting for a completed run.
+    void reportAbandoned(double ms) {
+        costReported = true;
+        fullCostMs = std::max(fullCostMs, ms);
+        overran = true;
+    }
+
+private:
+    void run(bool full) {
+        if (!dirty && !full) return;
+        dirty = false;
+        bool preview = !full && previewing();
+        lastWasPreview = preview;
+        sinceLast.restart();
+
+        QElapsedTimer cost;
+        cost.start();
+        recompute(preview);
+        if (!preview && !costReported) fullCostMs = double(cost.nsecsElapsed()) / 1e6;
+    }
+
+    Recompute recompute;
+    int intervalMs;
+    QTimer timer;
+    QElapsedTimer sinceLast;
+    double fullCostMs = 0;
+    bool dirty = false;
+    bool lastWasPreview = false;
+    bool costReported = false;
+    bool overran = false;
+};
+
+#endif
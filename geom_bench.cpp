@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "hull_core.h"
+#include "delaunay_core.h"
+#include "polygon_core.h"
+#include "segment_core.h"
+
+using namespace geom;
+
+// Sweeps every kernel over the standard input distributions at sizes 10^2 to
+// 10^max and prints one JSON document. Generators seed from (name, size), so
+// runs are reproducible across machines and standard libraries.
+//
+// usage: geom_bench [--max-exponent 7] [--budget-ms 2000] [--only <benchmark>]
+
+namespace {
+
+// splitmix64, so the sequence does not depend on the standard library.
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1).
+    double uniform() { return double(next() >> 11) * 0x1.0p-53; }
+    double uniform(double low, double high) { return low + (high - low) * uniform(); }
+
+    double gaussian() {
+        double u = uniform();
+        double v = uniform();
+        return std::sqrt(-2 * std::log(1 - u)) * std::cos(2 * M_PI * v);
+    }
+
+private:
+    uint64_t state;
+};
+
+const double EXTENT = 1000;
+
+std::vector<Point> uniformSquare(Random& rng, size_t n) {
+    std::vector<Point> points(n);
+    for (auto& p : points) p = Point(rng.uniform(-EXTENT, EXTENT), rng.uniform(-EXTENT, EXTENT));
+    return points;
+}
+
+std::vector<Point> uniformDisk(Random& rng, size_t n) {
+    std::vector<Point> points(n);
+    for (auto& p : points) {
+        double r = EXTENT * std::sqrt(rng.uniform());
+        double a = 2 * M_PI * rng.uniform();
+        p = Point(r * std::cos(a), r * std::sin(a));
+    }
+    return points;
+}
+
+std::vector<Point> onCircle(Random& rng, size_t n) {
+    std::vector<Point> points(n);
+    for (auto& p : points) {
+        double a = 2 * M_PI * rng.uniform();
+        p = Point(EXTENT * std::cos(a), EXTENT * std::sin(a));
+    }
+    return points;
+}
+
+std::vector<Point> gaussianClusters(Random& rng, size_t n) {
+    const size_t clusters = 16;
+    std::vector<Point> centers = uniformSquare(rng, clusters);
+    std::vector<Point> points(n);
+    for (auto& p : points) {
+        const Point& c = centers[rng.next() % clusters];
+        p = Point(c.x + 0.03 * EXTENT * rng.gaussian(), c.y + 0.03 * EXTENT * rng.gaussian());
+    }
+    return points;
+}
+
+// About four copies of every node of a square grid.
+std::vector<Point> gridWithDuplicates(Random& rng, size_t n) {
+    size_t side = std::max<size_t>(2, size_t(std::sqrt(double(n) / 4)));
+    double step = 2 * EXTENT / double(side - 1);
+    std::vector<Point> points(n);
+    for (auto& p : points) {
+        p = Point(-EXTENT + step * double(rng.next() % side), -EXTENT + step * double(rng.next() % side));
+    }
+    return points;
+}
+
+// Points within 1e-9 relative of one line.
+std::vector<Point> nearCollinear(Random& rng, size_t n) {
+    std::vector<Point> points(n);
+    for (auto& p : points) {
+        double t = rng.uniform(-EXTENT, EXTENT);
+        p = Point(t, 0.5 * t + 1e-9 * EXTENT * (rng.uniform() - 0.5));
+    }
+    return points;
+}
+
+struct Generator {
+    const char* name;
+    std::vector<Point> (*generate)(Random& rng, size_t n);
+};
+
+const Generator GENERATORS[] = {
+    {"square", uniformSquare},
+    {"disk", uniformDisk},
+    {"circle", onCircle},
+    {"clusters", gaussianClusters},
+    {"grid", gridWithDuplicates},
+    {"collinear", nearCollinear},
+};
+
+uint64_t seedFor(const std::string& name, size_t n) {
+    uint64_t seed = 1469598103934665603ull;
+    for (char c : name) seed = (seed ^ uint8_t(c)) * 1099511628211ull;
+    return seed ^ (uint64_t(n) * 0x9e3779b97f4a7c15ull);
+}
+
+// Simple polygon through the points, ordered by angle around their centroid.
+Polygon starPolygon(const std::vector<Point>& points) {
+    Point center;
+    for (const auto& p : points) center = center + p;
+    center = center * (1.0 / double(points.size()));
+
+    std::vector<std::pair<double, Point>> ordered;
+    for (const auto& p : points) ordered.emplace_back(std::atan2(p.y - center.y, p.x - center.x), p);
+    std::sort(ordered.begin(), ordered.end(),
+              [](const std::pair<double, Point>& a, const std::pair<double, Point>& b) { return a.first < b.first; });
+
+    Polygon poly;
+    for (const auto& entry : ordered) {
+        if (poly.points.empty() || entry.second.x != poly.points.back().x || entry.second.y != poly.points.back().y) {
+            poly.addPoint(entry.second);
+        }
+    }
+    return poly;
+}
+
+IntPoint toGrid(const Point& p) {
+    return IntPoint(int32_t(std::lround(p.x * 1000)), int32_t(std::lround(p.y * 1000)));
+}
+
+// Prepares the inputs for one size and returns the measured operation.
+typedef std::function<std::function<size_t()>(const std::vector<Point>& points)> Benchmark;
+
+struct BenchmarkEntry {
+    const char* name;
+    Benchmark prepare;
+};
+
+std::vector<BenchmarkEntry> benchmarks() {
+    std::vector<BenchmarkEntry> list;
+
+    list.push_back({"hull", [](const std::vector<Point>& points) {
+        return std::function<size_t()>([&points] { return convexHull(points).size(); });
+    }});
+
+    // The same wrap on float coordinate arrays and on grid points.
+    list.push_back({"hull_float_soa", [](const std::vector<Point>& points) {
+        auto xs = std::make_shared<std::vector<float>>(), ys = std::make_shared<std::vector<float>>();
+        for (const auto& p : points) {
+            xs->push_back(float(p.x));
+            ys->push_back(float(p.y));
+        }
+        return std::function<size_t()>([xs, ys] {
+            std::vector<size_t> hull;
+            convexHull(CoordinateSpan<float>(xs->data(), ys->data(), xs->size()), hull);
+            return hull.size();
+        });
+    }});
+
+    list.push_back({"hull_int32", [](const std::vector<Point>& points) {
+        auto grid = std::make_shared<std::vector<IntPoint>>();
+        for (const auto& p : points) grid->push_back(toGrid(p));
+        return std::function<size_t()>([grid] {
+            std::vector<size_t> hull;
+            convexHull(spanOf(*grid), hull);
+            return hull.size();
+        });
+    }});
+
+    list.push_back({"delaunay", [](const std::vector<Point>& points) {
+        return std::function<size_t()>([&points] { return delaunayTriangulation(points).size(); });
+    }});
+
+    list.push_back({"polygon_intersection", [](const std::vector<Point>& points) {
+        auto a = std::make_shared<Polygon>(starPolygon(points));
+        auto b = std::make_shared<Polygon>();
+        for (const auto& p : a->points) b->addPoint(Point(0.8 * p.x - 0.6 * p.y + 50, 0.6 * p.x + 0.8 * p.y));
+        return std::function<size_t()>([a, b] { return polygonIntersection(*a, *b).size(); });
+    }});
+
+    // Hulls of the points and of a rotated copy, once on doubles and once on
+    // grid points, where containment in a convex ring is batched per edge.
+    list.push_back({"convex_intersection", [](const std::vector<Point>& points) {
+        auto a = std::make_shared<Polygon>(), b = std::make_shared<Polygon>();
+        for (const auto& p : points) {
+            a->addPoint(p);
+            b->addPoint(Point(0.8 * p.x - 0.6 * p.y + 50, 0.6 * p.x + 0.8 * p.y));
+        }
+        a->computeConvexHull();
+        b->computeConvexHull();
+        return std::function<size_t()>([a, b] { return polygonIntersection(*a, *b).size(); });
+    }});
+
+    list.push_back({"convex_intersection_int32", [](const std::vector<Point>& points) {
+        auto a = std::make_shared<IntPolygon>(), b = std::make_shared<IntPolygon>();
+        for (const auto& p : points) {
+            a->addPoint(toGrid(p));
+            b->addPoint(toGrid(Point(0.8 * p.x - 0.6 * p.y + 50, 0.6 * p.x + 0.8 * p.y)));
+        }
+        a->computeConvexHull();
+        b->computeConvexHull();
+        return std::function<size_t()>([a, b] { return polygonIntersection(*a, *b).size(); });
+    }});
+
+    // Segments of about two average point spacings from every point, so the
+    // number of crossings grows linearly.
+    list.push_back({"segment_intersection", [](const std::vector<Point>& points) {
+        auto segments = std::make_shared<std::vector<Segment>>();
+        Random rng(seedFor("segments", points.size()));
+        double length = 4 * EXTENT / std::sqrt(double(points.size()));
+        for (const auto& p : points) {
+            double a = 2 * M_PI * rng.uniform();
+            Point q(p.x + length * std::cos(a), p.y + length * std::sin(a));
+            segments->emplace_back(toGrid(p), toGrid(q));
+        }
+        return std::function<size_t()>([segments] { return size_t(countSegmentIntersections(*segments)); });
+    }});
+
+    // Every point is a query against a fixed 1000-vertex star polygon.
+    list.push_back({"point_in_polygon", [](const std::vector<Point>& points) {
+        Random rng(seedFor("polygon", 1000));
+        auto polygon = std::make_shared<Polygon>(starPolygon(uniformDisk(rng, 1000)));
+        return std::function<size_t()>([&points, polygon] {
+            size_t inside = 0;
+            for (const auto& p : points) inside += isPointInsidePolygon(p, polygon->points) ? 1 : 0;
+            return inside;
+        });
+    }});
+
+    // Exact side of every point, on micro-unit grid coordinates as BigNumber.
+    list.push_back({"bignum_position", [](const std::vector<Point>& points) {
+        auto values = std::make_shared<std::vector<BigNumber>>();
+        values->reserve(2 * points.size());
+        for (const auto& p : points) {
+            IntPoint g = toGrid(p);
+            values->emplace_back(std::to_string(g.x));
+            values->emplace_back(std::to_string(g.y));
+        }
+        return std::function<size_t()>([values] {
+            BigNumber x1("-1000000"), y1("-500000"), x2("1000000"), y2("500000");
+            size_t left = 0;
+            for (size_t i = 0; i < values->size(); i += 2) {
+                left += exactPointPosition(x1, y1, x2, y2, (*values)[i], (*values)[i + 1]) > 0 ? 1 : 0;
+            }
+            return left;
+        });
+    }});
+
+    return list;
+}
+
+// ru_maxrss never goes down, so on Linux the high-water mark is reset before
+// each case through clear_refs and read back from VmHWM. Elsewhere the value
+// is the process peak so far.
+bool resetPeakRss() {
+    FILE* refs = std::fopen("/proc/self/clear_refs", "w");
+    if (!refs) return false;
+    bool reset = std::fputs("5", refs) >= 0;
+    return std::fclose(refs) == 0 && reset;
+}
+
+long peakRssKb() {
+    if (FILE* status = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        long kb = -1;
+        while (std::fgets(line, sizeof(line), status)) {
+            if (std::sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+        }
+        std::fclose(status);
+        if (kb >= 0) return kb;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int maxExponent = 7;
+    double budgetMs = 2000;
+    std::string only;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--max-exponent") == 0) {
+            maxExponent = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--budget-ms") == 0) {
+            budgetMs = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--only") == 0) {
+            only = argv[i + 1];
+        } else {
+            std::fprintf(stderr, "usage: geom_bench [--max-exponent 7] [--budget-ms 2000] [--only <benchmark>]\n");
+            return 1;
+        }
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const double minimumMs = 50;
+    bool first = true;
+
+    std::printf("{\n  \"budget_ms\": %.0f,\n  \"results\": [", budgetMs);
+    for (const auto& benchmark : benchmarks()) {
+        if (!only.empty() && only != benchmark.name) continue;
+
+        for (const auto& generator : GENERATORS) {
+            size_t n = 100;
+            for (int exponent = 2; exponent <= maxExponent; exponent++, n *= 10) {
+                resetPeakRss();
+                Random rng(seedFor(generator.name, n));
+                std::vector<Point> points = generator.generate(rng, n);
+                std::function<size_t()> run = benchmark.prepare(points);
+
+                // Small sizes repeat until the measurement covers minimumMs; the checksum
+                // is the result of the last run.
+                size_t iterations = 0;
+                size_t checksum = 0;
+                double elapsedMs = 0;
+                Clock::time_point start = Clock::now();
+                do {
+                    checksum = run();
+                    iterations++;
+                    elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                } while (elapsedMs < minimumMs);
+
+                double nsPerOp = elapsedMs * 1e6 / double(iterations);
+                std::printf("%s\n    {\"benchmark\": \"%s\", \"generator\": \"%s\", \"n\": %zu, "
+                            "\"iterations\": %zu, \"ns_per_op\": %.0f, \"points_per_s\": %.4g, "
+                            "\"peak_rss_kb\": %ld, \"checksum\": %zu}",
+                            first ? "" : ",", benchmark.name, generator.name, n, iterations,
+                            nsPerOp, double(n) * 1e9 / nsPerOp, peakRssKb(), checksum);
+                std::fflush(stdout);
+                first = false;
+
+                // Quadratic kernels would take hours at 10^7; the next size
+                // costs at least ten times this one.
+                if (nsPerOp * 1e-6 > budgetMs / 10) break;
+            }
+        }
+    }
+    std::printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,455 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hull_core.h"
+#include "delaunay_core.h"
+#include "polygon_core.h"
+#include "segment_core.h"
+#include "decimal.h"
+
+using namespace geom;
+
+static void usage() {
+    std::cerr <<
+        "usage: geom_cli <command> [arguments] [-o output]\n"
+        "  hull <points>                          convex hull vertices\n"
+        "  delaunay <points>                      triangles as point index triples\n"
+        "  intersection|union|difference|minkowski <polygon> <polygon>\n"
+        "                                         exact on integer vertices below 2^30\n"
+        "  offset <polygon> <distance> [round|miter]\n"
+        "  triangulate <polygon>                  triangle index triples\n"
+        "  simplify <polygon> <tolerance> [vw|dp]\n"
+        "  segments <segments> [count]            intersecting pairs and points, or their count\n"
+        "  position <segment> <points>            exact side per decimal point: 1, -1 or 0\n"
+        "  positions <queries> [csv|bin]          exact side per \"x1 y1 x2 y2 xp yp\" line, in order\n"
+        "  side <polyline> <points> [tolerance]   side per integer point with a tolerance band\n"
+        "Points and polygon vertices are one \"x y\" pair per line, segments are\n"
+        "\"x1 y1 x2 y2\". Commas and parentheses are treated as blanks, '#' starts a\n"
+        "comment and '-' reads standard input.\n";
+}
+
+// Splits every non-empty line into number tokens.
+static bool readRecords(const std::string& path, std::vector<std::vector<std::string>>& records) {
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cerr << "geom_cli: cannot open " << path << "\n";
+            return false;
+        }
+        in = &file;
+    }
+
+    std::string line;
+    while (std::getline(*in, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        for (char& c : line) {
+            if (c == ',' || c == '(' || c == ')' || c == ';') c = ' ';
+        }
+        std::istringstream tokens(line);
+        std::vector<std::string> record;
+        std::string token;
+        while (tokens >> token) record.push_back(token);
+        if (!record.empty()) records.push_back(record);
+    }
+    return true;
+}
+
+static bool readFile(const std::string& path, std::string& text) {
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (path != "-") {
+        file.open(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "geom_cli: cannot open " << path << "\n";
+            return false;
+        }
+        in = &file;
+    }
+
+    std::ostringstream contents;
+    contents << in->rdbuf();
+    text = contents.str();
+    return true;
+}
+
+static bool toDouble(const std::string& token, double& value) {
+    char* end = nullptr;
+    value = std::strtod(token.c_str(), &end);
+    return end != token.c_str() && *end == '\0';
+}
+
+static bool readPoints(const std::string& path, std::vector<Point>& points) {
+    std::vector<std::vector<std::string>> records;
+    if (!readRecords(path, records)) return false;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        double x, y;
+        if (records[i].size() != 2 || !toDouble(records[i][0], x) || !toDouble(records[i][1], y)) {
+            std::cerr << "geom_cli: " << path << ": record " << i + 1 << " is not an x y pair\n";
+            return false;
+        }
+        points.emplace_back(x, y);
+    }
+    return true;
+}
+
+static bool readPolygon(const std::string& path, Polygon& poly) {
+    return readPoints(path, poly.points);
+}
+
+static bool onGrid(double v) {
+    return v == std::floor(v) && v >= -IntegerKernel::COORDINATE_LIMIT && v < IntegerKernel::COORDINATE_LIMIT;
+}
+
+static bool toGrid(const std::string& token, int32_t& value) {
+    double v;
+    if (!toDouble(token, v) || !onGrid(v)) return false;
+    value = int32_t(v);
+    return true;
+}
+
+// False unless every vertex is a grid point.
+static bool toGrid(const Polygon& poly, IntPolygon& grid) {
+    for (const auto& p : poly.points) {
+        if (!onGrid(p.x) || !onGrid(p.y)) return false;
+        grid.addPoint(IntPoint(int32_t(p.x), int32_t(p.y)));
+    }
+    return true;
+}
+
+static void writePoints(std::ostream& out, const std::vector<Point>& points) {
+    char buffer[64];
+    for (const auto& p : points) {
+        std::snprintf(buffer, sizeof(buffer), "%.17g %.17g\n", p.x, p.y);
+        out << buffer;
+    }
+}
+
+static int runHull(const std::vector<std::string>& args, std::ostream& out) {
+    std::vector<Point> points;
+    if (args.size() != 1 || !readPoints(args[0], points)) return 1;
+
+    std::vector<Point> hull;
+    for (size_t idx : convexHull(points)) {
+        hull.push_back(points[idx]);
+    }
+    writePoints(out, hull);
+    return 0;
+}
+
+static int runDelaunay(const std::vector<std::string>& args, std::ostream& out) {
+    std::vector<Point> points;
+    if (args.size() != 1 || !readPoints(args[0], points)) return 1;
+
+    for (const auto& t : delaunayTriangulation(points)) {
+        out << t.p1 << ' ' << t.p2 << ' ' << t.p3 << '\n';
+    }
+    return 0;
+}
+
+static int runBoolean(const std::string& command, const std::vector<std::string>& args, std::ostream& out) {
+    Polygon a, b;
+    if (args.size() != 2 || !readPolygon(args[0], a) || !readPolygon(args[1], b)) return 1;
+
+    IntPolygon gridA, gridB;
+    if (command != "minkowski" && toGrid(a, gridA) && toGrid(b, gridB)) {
+        gridA.computeConvexHull();
+        gridB.computeConvexHull();
+
+        IntPolygon result;
+        if (command == "intersection") {
+            polygonIntersection(gridA, gridB, result);
+        } else if (command == "union") {
+            polygonUnion(gridA, gridB, result);
+        } else {
+            polygonDifference(gridA, gridB, result);
+        }
+        std::vector<Point> points;
+        for (const auto& p : result.points) points.emplace_back(p.x, p.y);
+        writePoints(out, points);
+        return 0;
+    }
+
+    a.computeConvexHull();
+    b.computeConvexHull();
+
+    Polygon result;
+    if (command == "intersection") {
+        result = polygonIntersection(a, b);
+    } else if (command == "union") {
+        result = polygonUnion(a, b);
+    } else if (command == "difference") {
+        result = polygonDifference(a, b);
+    } else {
+        result = minkowskiSum(a, b);
+    }
+    writePoints(out, result.points);
+    return 0;
+}
+
+static int runOffset(const std::vector<std::string>& args, std::ostream& out) {
+    Polygon poly;
+    double distance;
+    if (args.size() < 2 || args.size() > 3 || !readPolygon(args[0], poly) || !toDouble(args[1], distance)) {
+        return 1;
+    }
+    JoinType join = ROUND_JOIN;
+    if (args.size() == 3) {
+        if (args[2] == "miter") {
+            join = MITER_JOIN;
+        } else if (args[2] != "round") {
+            return 1;
+        }
+    }
+
+    poly.computeConvexHull();
+    writePoints(out, offsetPolygon(poly, distance, join).points);
+    return 0;
+}
+
+static int runTriangulate(const std::vector<std::string>& args, std::ostream& out) {
+    Polygon poly;
+    if (args.size() != 1 || !readPolygon(args[0], poly)) return 1;
+
+    std::vector<uint32_t> triangles = triangulatePolygon(poly);
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        out << triangles[t] << ' ' << triangles[t + 1] << ' ' << triangles[t + 2] << '\n';
+    }
+    return 0;
+}
+
+static int runSimplify(const std::vector<std::string>& args, std::ostream& out) {
+    Polygon poly;
+    double tolerance;
+    if (args.size() < 2 || args.size() > 3 || !readPolygon(args[0], poly) || !toDouble(args[1], tolerance)) {
+        return 1;
+    }
+    bool douglasPeucker = args.size() == 3 && args[2] == "dp";
+    if (args.size() == 3 && !douglasPeucker && args[2] != "vw") return 1;
+
+    SimplificationIndex index = douglasPeucker ? douglasPeuckerIndex(poly.points, true)
+                                               : visvalingamIndex(poly.points, true);
+    writePoints(out, simplifyPolygon(poly, index, tolerance).points);
+    return 0;
+}
+
+static int runSegments(const std::vector<std::string>& args, std::ostream& out) {
+    std::vector<std::vector<std::string>> records;
+    if (args.empty() || args.size() > 2 || (args.size() == 2 && args[1] != "count") ||
+        !readRecords(args[0], records)) {
+        return 1;
+    }
+
+    std::vector<Segment> segments;
+    for (size_t i = 0; i < records.size(); i++) {
+        int32_t c[4];
+        bool ok = records[i].size() == 4;
+        for (size_t k = 0; ok && k < 4; k++) ok = toGrid(records[i][k], c[k]);
+        if (!ok) {
+            std::cerr << "geom_cli: " << args[0] << ": record " << i + 1
+                      << " is not an integer x1 y1 x2 y2 segment\n";
+            return 1;
+        }
+        segments.emplace_back(IntPoint(c[0], c[1]), IntPoint(c[2], c[3]));
+    }
+
+    if (args.size() == 2) {
+        out << countSegmentIntersections(segments) << '\n';
+        return 0;
+    }
+
+    char buffer[96];
+    for (const auto& hit : segmentIntersections(segments)) {
+        Point p = hit.point.toPoint();
+        std::snprintf(buffer, sizeof(buffer), "%u %u %.17g %.17g\n", hit.first, hit.second, p.x, p.y);
+        out << buffer;
+    }
+    return 0;
+}
+
+static int runPosition(const std::vector<std::string>& args, std::ostream& out) {
+    std::vector<std::vector<std::string>> segment;
+    if (args.size() != 2 || !readRecords(args[0], segment)) return 1;
+
+    std::vector<std::string> ends;
+    for (const auto& record : segment) {
+        ends.insert(ends.end(), record.begin(), record.end());
+    }
+    if (ends.size() != 4) {
+        std::cerr << "geom_cli: " << args[0] << ": expected x1 y1 x2 y2\n";
+        return 1;
+    }
+    Decimal end[4];
+    for (size_t k = 0; k < 4; k++) {
+        const char* first = ends[k].data();
+        const char* last = first + ends[k].size();
+        if (Decimal::parse(first, last, end[k]) != last) {
+            std::cerr << "geom_cli: " << args[0] << ": " << ends[k] << " is not a decimal number\n";
+            return 1;
+        }
+    }
+
+    // Point files can hold millions of pairs, so they skip readRecords.
+    std::string text;
+    std::vector<DecimalPoint> points;
+    if (!readFile(args[1], text)) return 1;
+    size_t badLine = parseDecimalPoints(text.data(), text.data() + text.size(), points);
+    if (badLine != 0) {
+        std::cerr << "geom_cli: " << args[1] << ": line " << badLine << " is not an x y pair\n";
+        return 1;
+    }
+
+    std::string result;
+    result.reserve(3 * points.size());
+    for (const auto& p : points) {
+        int side = exactPointPosition(end[0], end[1], end[2], end[3], p.x, p.y);
+        result += side < 0 ? "-1\n" : (side > 0 ? "1\n" : "0\n");
+    }
+    out << result;
+    return 0;
+}
+
+static int runPositions(const std::vector<std::string>& args, std::ostream& out) {
+    if (args.empty() || args.size() > 2) return 1;
+    bool binary = args.size() == 2 && args[1] == "bin";
+    if (args.size() == 2 && !binary && args[1] != "csv") return 1;
+
+    std::string text;
+    if (!readFile(args[0], text)) return 1;
+
+    std::string result;
+    auto sink = [&](const int8_t* sides, size_t count) {
+        if (binary) {
+            out.write(reinterpret_cast<const char*>(sides), std::streamsize(count));
+            return;
+        }
+        result.clear();
+        for (size_t i = 0; i < count; i++) {
+            result += sides[i] < 0 ? "-1\n" : (sides[i] > 0 ? "1\n" : "0\n");
+        }
+        out << result;
+    };
+
+    size_t badLine = batchPointPositions(text.data(), text.data() + text.size(), sink);
+    if (badLine != 0) {
+        std::cerr << "geom_cli: " << args[0] << ": line " << badLine << " is not x1 y1 x2 y2 xp yp\n";
+        return 1;
+    }
+    return 0;
+}
+
+static bool readGridPoints(const std::string& path, std::vector<int32_t>& xs, std::vector<int32_t>& ys) {
+    std::vector<std::vector<std::string>> records;
+    if (!readRecords(path, records)) return false;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        int32_t x, y;
+        if (records[i].size() != 2 || !toGrid(records[i][0], x) || !toGrid(records[i][1], y)) {
+            std::cerr << "geom_cli: " << path << ": record " << i + 1 << " is not an integer x y pair\n";
+            return false;
+        }
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+    return true;
+}
+
+static int runSide(const std::vector<std::string>& args, std::ostream& out) {
+    std::vector<int32_t> lineX, lineY, xs, ys;
+    SideTolerance tolerance;
+    if (args.size() < 2 || args.size() > 3 || !readGridPoints(args[0], lineX, lineY) ||
+        !readGridPoints(args[1], xs, ys) || (args.size() == 3 && !toDouble(args[2], tolerance.distance))) {
+        return 1;
+    }
+
+    std::vector<IntPoint> polyline;
+    for (size_t i = 0; i < lineX.size(); i++) {
+        polyline.emplace_back(lineX[i], lineY[i]);
+    }
+
+    std::vector<int8_t> sides(xs.size());
+    if (polyline.size() == 2) {
+        pointSegmentSides(polyline[0], polyline[1], xs.data(), ys.data(), xs.size(), sides.data(), tolerance);
+    } else {
+        PolylineSideIndex index;
+        if (!index.build(polyline)) {
+            std::cerr << "geom_cli: " << args[0] << ": polyline must advance along its first-to-last direction\n";
+            return 1;
+        }
+        index.sides(xs.data(), ys.data(), xs.size(), sides.data(), tolerance);
+    }
+
+    for (int8_t side : sides) {
+        out << int(side) << '\n';
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> args;
+    std::string outputPath;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (args.empty()) {
+        usage();
+        return 1;
+    }
+
+    std::ofstream file;
+    std::ostream* out = &std::cout;
+    if (!outputPath.empty()) {
+        file.open(outputPath);
+        if (!file) {
+            std::cerr << "geom_cli: cannot write " << outputPath << "\n";
+            return 1;
+        }
+        out = &file;
+    }
+
+    std::string command = args[0];
+    args.erase(args.begin());
+
+    int status;
+    if (command == "hull") {
+        status = runHull(args, *out);
+    } else if (command == "delaunay") {
+        status = runDelaunay(args, *out);
+    } else if (command == "intersection" || command == "union" ||
+               command == "difference" || command == "minkowski") {
+        status = runBoolean(command, args, *out);
+    } else if (command == "offset") {
+        status = runOffset(args, *out);
+    } else if (command == "triangulate") {
+        status = runTriangulate(args, *out);
+    } else if (command == "simplify") {
+        status = runSimplify(args, *out);
+    } else if (command == "segments") {
+        status = runSegments(args, *out);
+    } else if (command == "position") {
+        status = runPosition(args, *out);
+    } else if (command == "side") {
+        status = runSide(args, *out);
+    } else if (command == "positions") {
+        status = runPositions(args, *out);
+    } else {
+        status = 1;
+    }
+
+    if (status != 0) usage();
+    return status;
+}
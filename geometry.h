@@ -0,0 +1,100 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <cstdint>
+
+namespace geom {
+
+struct Point {
+    double x, y;
+    Point() : x(0), y(0) {}
+    Point(double x, double y) : x(x), y(y) {}
+
+    Point operator+(const Point& other) const { return Point(x + other.x, y + other.y); }
+    Point operator-(const Point& other) const { return Point(x - other.x, y - other.y); }
+    Point operator*(double scalar) const { return Point(x * scalar, y * scalar); }
+    double dot(const Point& other) const { return x * other.x + y * other.y; }
+    double cross(const Point& other) const { return x * other.y - y * other.x; }
+    double dist2() const { return x*x + y*y; }
+};
+
+// Snapped grid point. Coordinates stay in [-2^30, 2^30) so every coordinate
+// difference fits int32 and every cross or dot product of differences fits int64.
+struct IntPoint {
+    int32_t x, y;
+    IntPoint() : x(0), y(0) {}
+    IntPoint(int32_t x, int32_t y) : x(x), y(y) {}
+
+    IntPoint operator+(const IntPoint& other) const { return IntPoint(x + other.x, y + other.y); }
+    IntPoint operator-(const IntPoint& other) const { return IntPoint(x - other.x, y - other.y); }
+    bool operator==(const IntPoint& other) const { return x == other.x && y == other.y; }
+    int64_t dot(const IntPoint& other) const { return int64_t(x) * other.x + int64_t(y) * other.y; }
+    int64_t cross(const IntPoint& other) const { return int64_t(x) * other.y - int64_t(y) * other.x; }
+    int64_t dist2() const { return int64_t(x) * x + int64_t(y) * y; }
+};
+
+// Exact point (xn / den, yn / den) with den > 0, as produced by the integer
+// intersection kernels. Nothing is divided until the point is rounded or converted.
+struct RationalPoint {
+    __int128 xn, yn;
+    int64_t den;
+    RationalPoint() : xn(0), yn(0), den(1) {}
+    RationalPoint(const IntPoint& p) : xn(p.x), yn(p.y), den(1) {}
+    RationalPoint(__int128 xn, __int128 yn, int64_t den) : xn(xn), yn(yn), den(den) {}
+
+    bool isInteger() const { return den == 1 || (xn % den == 0 && yn % den == 0); }
+    Point toPoint() const { return Point(double(xn) / double(den), double(yn) / double(den)); }
+
+    // Nearest grid point, halves rounded up.
+    IntPoint round() const { return IntPoint(roundedQuotient(xn), roundedQuotient(yn)); }
+
+private:
+    int32_t roundedQuotient(__int128 num) const {
+        __int128 twiceDen = __int128(den) * 2;
+        __int128 twice = 2 * num + den;
+        __int128 q = twice / twiceDen;
+        if (twice % twiceDen != 0 && twice < 0) q--;
+        return int32_t(q);
+    }
+};
+
+// sign(a / b - c / d) for b, d > 0, exact for |a|, |c| < 2^127 and b, d < 2^63.
+inline int compareRatio(__int128 a, int64_t b, __int128 c, int64_t d) {
+    int sa = (a > 0) - (a < 0), sc = (c > 0) - (c < 0);
+    if (sa != sc) return sa < sc ? -1 : 1;
+    if (sa == 0) return 0;
+    if (b == d) return a < c ? -1 : (a > c ? 1 : 0);
+
+    typedef unsigned __int128 uint128;
+    uint128 ma = uint128(sa > 0 ? a : -a), mc = uint128(sc > 0 ? c : -c);
+    uint128 la = uint128(uint64_t(ma)) * uint64_t(d), lc = uint128(uint64_t(mc)) * uint64_t(b);
+    uint128 ha = uint128(uint64_t(ma >> 64)) * uint64_t(d) + (la >> 64);
+    uint128 hc = uint128(uint64_t(mc >> 64)) * uint64_t(b) + (lc >> 64);
+    uint64_t lowA = uint64_t(la), lowC = uint64_t(lc);
+
+    int magnitude = ha != hc ? (ha < hc ? -1 : 1) : (lowA != lowC ? (lowA < lowC ? -1 : 1) : 0);
+    return sa > 0 ? magnitude : -magnitude;
+}
+
+// Lexicographic (x, then y) comparison of exact points: -1, 0 or 1.
+inline int compare(const RationalPoint& p, const RationalPoint& q) {
+    int cx = compareRatio(p.xn, p.den, q.xn, q.den);
+    return cx != 0 ? cx : compareRatio(p.yn, p.den, q.yn, q.den);
+}
+
+// 0 for collinear, 1 for clockwise and 2 for counter-clockwise (p, q, r).
+inline int orientation(const Point& p, const Point& q, const Point& r) {
+    double val = (q.y - p.y) * (r.x - q.x) - (q.x - p.x) * (r.y - q.y);
+    if (val == 0) return 0;
+    return (val > 0) ? 1 : 2;
+}
+
+inline int orientation(const IntPoint& p, const IntPoint& q, const IntPoint& r) {
+    int64_t val = int64_t(q.y - p.y) * (r.x - q.x) - int64_t(q.x - p.x) * (r.y - q.y);
+    if (val == 0) return 0;
+    return (val > 0) ? 1 : 2;
+}
+
+}
+
+#endif
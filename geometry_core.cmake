@@ -0,0 +1,24 @@
+if(NOT TARGET geometry_core)
+    find_package(Threads REQUIRED)
+
+    add_library(geometry_core STATIC
+        ${CMAKE_CURRENT_LIST_DIR}/hull_core.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/delaunay_core.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/polygon_core.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/segment_core.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/big_number.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/decimal.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/box_tree.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/trace.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/scratch_arena.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/scene_file.cpp
+        ${CMAKE_CURRENT_LIST_DIR}/alloc_counter_fallback.cpp
+    )
+    target_include_directories(geometry_core PUBLIC ${CMAKE_CURRENT_LIST_DIR})
+    target_link_libraries(geometry_core PUBLIC Threads::Threads)
+
+    # Replaces the global operator new and delete with counting ones, so only
+    # programs that show allocation counts link it.
+    add_library(geometry_alloc_counter OBJECT ${CMAKE_CURRENT_LIST_DIR}/alloc_counter.cpp)
+    target_include_directories(geometry_alloc_counter PUBLIC ${CMAKE_CURRENT_LIST_DIR})
+endif()
@@ -0,0 +1,26 @@
+#include "hull_core.h"
+
+namespace geom {
+
+std::vector<size_t> convexHull(const std::vector<Point>& points,
+                               const std::atomic<bool>* cancel) {
+    std::vector<size_t> hullIndices;
+    convexHull(spanOf(points), hullIndices, cancel);
+    return hullIndices;
+}
+
+void convexHull(const std::vector<Point>& points, std::vector<size_t>& hullIndices,
+                const std::atomic<bool>* cancel) {
+    convexHull(spanOf(points), hullIndices, cancel);
+}
+
+// Every supported coordinate type, so the library build checks them all.
+template void convexHull(const PointSpan<BasicPoint<float>>&, std::vector<size_t>&, const std::atomic<bool>*);
+template void convexHull(const PointSpan<IntPoint>&, std::vector<size_t>&, const std::atomic<bool>*);
+template void convexHull(const PointSpan<BasicPoint<int64_t>>&, std::vector<size_t>&, const std::atomic<bool>*);
+template void convexHull(const CoordinateSpan<float>&, std::vector<size_t>&, const std::atomic<bool>*);
+template void convexHull(const CoordinateSpan<double>&, std::vector<size_t>&, const std::atomic<bool>*);
+template void convexHull(const CoordinateSpan<int32_t>&, std::vector<size_t>&, const std::atomic<bool>*);
+template void convexHull(const CoordinateSpan<int64_t>&, std::vector<size_t>&, const std::atomic<bool>*);
+
+}
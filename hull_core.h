@@ -0,0 +1,73 @@
+#ifndef HULL_CORE_H
+#define HULL_CORE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+#include "geometry.h"
+#include "point_traits.h"
+#include "trace.h"
+
+namespace geom {
+
+// Gift wrapping from the lowest point; returns hull vertex indices in order,
+// or nothing when cancel is raised before the wrap closes.
+std::vector<size_t> convexHull(const std::vector<Point>& points,
+                               const std::atomic<bool>* cancel = nullptr);
+// Same, into hull, whose capacity is reused.
+void convexHull(const std::vector<Point>& points, std::vector<size_t>& hull,
+                const std::atomic<bool>* cancel = nullptr);
+
+// Same over any point source from point_traits.h, read in place.
+template<typename Source>
+void convexHull(const Source& points, std::vector<size_t>& hullIndices,
+                const std::atomic<bool>* cancel = nullptr) {
+    hullIndices.clear();
+    size_t n = points.size();
+    if (n < 3) return;
+
+    TraceScope prefilter("hull.prefilter");
+    size_t startIndex = 0;
+    for (size_t i = 1; i < n; i++) {
+        if (points.y(i) < points.y(startIndex) ||
+            (points.y(i) == points.y(startIndex) &&
+             points.x(i) < points.x(startIndex))) {
+            startIndex = i;
+        }
+    }
+
+    prefilter.end();
+
+    TraceScope wrap("hull.wrap");
+    size_t current = startIndex;
+    do {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            hullIndices.clear();
+            return;
+        }
+
+        hullIndices.push_back(current);
+        size_t next = (current + 1) % n;
+
+        // Among collinear candidates the farthest wins, so duplicates and
+        // points inside hull edges are skipped instead of looping forever.
+        for (size_t i = 0; i < n; i++) {
+            int turn = orientation(points, current, i, next);
+            if (turn == 2 ||
+                (turn == 0 && squaredDistance(points, current, i) >
+                              squaredDistance(points, current, next))) {
+                next = i;
+            }
+        }
+
+        current = next;
+    } while (!(points.x(current) == points.x(startIndex) && points.y(current) == points.y(startIndex)) &&
+             hullIndices.size() < n);
+    wrap.end();
+    traceCounter("hull.orientation_tests", int64_t(hullIndices.size() * n));
+}
+
+}
+
+#endif
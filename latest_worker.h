@@ -0,0 +1,132 @@
+#ifndef LATEST_WORKER_H
+#define LATEST_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace geom {
+
+// Single writer, single reader. The writer fills back() and publishes it; the
+// reader's read() swaps in the newest published buffer without blocking, and the
+// reference stays valid until its next read().
+template<typename T>
+class TripleBuffer {
+public:
+    T& back() { return buffers[backIndex]; }
+
+    void publish() {
+        int previous = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+        backIndex = previous & INDEX;
+    }
+
+    const T& read() {
+        if (middle.load(std::memory_order_relaxed) & FRESH) {
+            int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & INDEX;
+        }
+        return buffers[frontIndex];
+    }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    T buffers[3];
+    int backIndex = 0;
+    std::atomic<int> middle{1};
+    int frontIndex = 2;
+};
+
+// Runs compute on one background thread. submit() replaces any input still
+// waiting and raises the cancel flag of the one in flight, so a burst of
+// submissions costs at most one abandoned run and one run on the newest input.
+// compute polls the flag and returns false when it gave up; completed results
+// go through a TripleBuffer, and published() is called from the worker thread.
+// Inputs rotate through draft(), the pending slot and the worker, so a caller
+// that fills draft() in place reuses the buffers of spent inputs.
+template<typename Input, typename Result>
+class LatestWinsWorker {
+public:
+    typedef std::function<bool(const Input& input, Result& result, const std::atomic<bool>& cancelled)> Compute;
+
+    LatestWinsWorker(Compute compute, std::function<void()> published)
+        : compute(std::move(compute)), published(std::move(published)),
+          thread(&LatestWinsWorker::run, this) {}
+
+    ~LatestWinsWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            cancelled = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    LatestWinsWorker(const LatestWinsWorker&) = delete;
+    LatestWinsWorker& operator=(const LatestWinsWorker&) = delete;
+
+    void submit(Input input) {
+        next = std::move(input);
+        submit();
+    }
+
+    // Input for the next submit(), holding stale data from an earlier one;
+    // submitter thread only.
+    Input& draft() { return next; }
+
+    void submit() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(pending, next);
+            hasPending = true;
+            cancelled = true;
+        }
+        wake.notify_one();
+    }
+
+    // Newest completed result; reader thread only.
+    const Result& latest() { return results.read(); }
+
+private:
+    void run() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return hasPending || stopping; });
+                if (stopping) return;
+                std::swap(running, pending);
+                hasPending = false;
+                cancelled = false;
+            }
+
+            if (compute(running, results.back(), cancelled)) {
+                results.publish();
+                published();
+            }
+        }
+    }
+
+    Compute compute;
+    std::function<void()> published;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    Input next;
+    Input pending;
+    Input running;
+    bool hasPending = false;
+    bool stopping = false;
+    std::atomic<bool> cancelled{false};
+    TripleBuffer<Result> results;
+
+    std::thread thread;
+};
+
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include <QLabel>
 #include <cmath>
 
+#include "segment_core.h"
+
 class SegmentWidget : public QWidget
 {
     Q_OBJECT
@@ -88,27 +90,9 @@ private:
         QPoint B = segmentPoints[1];
         QPoint P = point;
 
-        int cross = (B.x() - A.x()) * (P.y() - A.y()) -
-                    (B.y() - A.y()) * (P.x() - A.x());
-
-        int ABx = B.x() - A.x();
-        int ABy = B.y() - A.y();
-        int APx = P.x() - A.x();
-        int APy = P.y() - A.y();
-
-        double dotAB = ABx*ABx + ABy*ABy;
-        double dotAP = ABx*APx + ABy*APy;
-        double t = (dotAB != 0) ? dotAP / dotAB : 0;
-
-        double distance = abs(cross) / sqrt(ABx*ABx + ABy*ABy);
-
-        if (distance <= 5 && t >= -0.1 && t <= 1.1) {
-            result = 0;
-        } else if (cross > 0) {
-            result = 1;
-        } else {
-            result = -1;
-        }
+        result = geom::pointSegmentSide(geom::IntPoint(A.x(), A.y()),
+                                        geom::IntPoint(B.x(), B.y()),
+                                        geom::IntPoint(P.x(), P.y()));
 
         resultLabel->setText(QString::number(result));
         update();
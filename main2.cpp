@@ -9,33 +9,56 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QFileDialog>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "segment_core.h"
+#include "box_tree.h"
+#include "frame_scheduler.h"
 
 class Widget : public QWidget
 {
     Q_OBJECT
 
 public:
-    Widget(QWidget *parent = nullptr) : QWidget(parent), isInteractiveMode(false), selectedPointIndex(-1), selectedSegmentIndex(-1)
+    Widget(QWidget *parent = nullptr) : QWidget(parent), isInteractiveMode(false), selectedPointIndex(-1), selectedSegmentIndex(-1),
+        movedSegmentIndex(-1), scheduler([this](bool preview) { recomputeMoved(preview); })
     {
-        segments.resize(2);
-
-        calculateButton = new QPushButton("Рассчитать пересечение", this);
+        calculateButton = new QPushButton("Рассчитать пересечения", this);
+        QPushButton *loadButton = new QPushButton("Загрузить из файла", this);
+        QPushButton *clearButton = new QPushButton("Очистить", this);
         interactiveCheckbox = new QCheckBox("Интерактивный режим", this);
-        QLabel *infoLabel = new QLabel("Кликните 4 точки для создания двух отрезков", this);
+        countOnlyCheckbox = new QCheckBox("Только подсчёт", this);
+        QLabel *infoLabel = new QLabel("Кликните две точки для каждого отрезка или загрузите файл со строками \"x1 y1 x2 y2\"", this);
+        resultLabel = new QLabel(this);
 
         QVBoxLayout *mainLayout = new QVBoxLayout(this);
         QHBoxLayout *controlLayout = new QHBoxLayout();
 
         controlLayout->addWidget(calculateButton);
+        controlLayout->addWidget(loadButton);
+        controlLayout->addWidget(clearButton);
         controlLayout->addWidget(interactiveCheckbox);
+        controlLayout->addWidget(countOnlyCheckbox);
         controlLayout->addStretch();
 
         mainLayout->addLayout(controlLayout);
         mainLayout->addWidget(infoLabel);
+        mainLayout->addWidget(resultLabel);
         mainLayout->addStretch();
 
         connect(calculateButton, &QPushButton::clicked, this, &Widget::calculateIntersection);
+        connect(loadButton, &QPushButton::clicked, this, &Widget::loadSegments);
+        connect(clearButton, &QPushButton::clicked, this, &Widget::clearSegments);
         connect(interactiveCheckbox, &QCheckBox::toggled, this, &Widget::toggleInteractiveMode);
+        connect(countOnlyCheckbox, &QCheckBox::toggled, this, &Widget::calculateIntersection);
 
         setMinimumSize(800, 600);
     }
@@ -50,32 +73,39 @@ protected:
 
         QPen segmentPen(Qt::black, 2);
         QPen pointPen(Qt::blue, 2);
+        bool detailed = segments.size() <= LABEL_LIMIT;
 
         for (int i = 0; i < segments.size(); ++i) {
             const Segment &seg = segments[i];
             if (seg.isValid()) {
                 painter.setPen(segmentPen);
                 painter.drawLine(seg.p1, seg.p2);
+            }
+            if (!detailed) continue;
 
-                painter.setPen(pointPen);
-                painter.setBrush(Qt::white);
+            painter.setPen(pointPen);
+            painter.setBrush(Qt::white);
+            if (seg.placed >= 1) {
                 painter.drawEllipse(seg.p1, POINT_RADIUS, POINT_RADIUS);
-                painter.drawEllipse(seg.p2, POINT_RADIUS, POINT_RADIUS);
-
                 painter.drawText(seg.p1 + QPoint(-10, -10), QString("P%1-1").arg(i+1));
+            }
+            if (seg.placed == 2) {
+                painter.drawEllipse(seg.p2, POINT_RADIUS, POINT_RADIUS);
                 painter.drawText(seg.p2 + QPoint(-10, -10), QString("P%1-2").arg(i+1));
             }
         }
 
         painter.setPen(QPen(Qt::red, 3));
         painter.setBrush(Qt::red);
-        for (const QPoint &p : intersectionPoints) {
-            painter.drawEllipse(p, POINT_RADIUS, POINT_RADIUS);
+        for (const auto &crossing : crossings) {
+            painter.drawEllipse(crossing.second, POINT_RADIUS, POINT_RADIUS);
         }
 
+        if (crossings.size() > size_t(LABEL_LIMIT)) return;
         painter.setPen(Qt::darkRed);
-        for (const QPoint &p : intersectionPoints) {
-            painter.drawText(p + QPoint(15, -5),
+        for (const auto &crossing : crossings) {
+            const QPointF &p = crossing.second;
+            painter.drawText(p + QPointF(15, -5),
                              QString("(%1, %2)").arg(p.x()).arg(p.y()));
         }
     }
@@ -83,34 +113,17 @@ protected:
     void mousePressEvent(QMouseEvent *event) override
     {
         if (isInteractiveMode) {
-            QPoint clickPos = event->pos();
-            QPoint closestPoint = findClosestPoint(clickPos);
-
-            if (!closestPoint.isNull()) {
-                for (int i = 0; i < segments.size(); ++i) {
-                    if (segments[i].p1 == closestPoint) {
-                        selectedPointIndex = 0;
-                        selectedSegmentIndex = i;
-                        break;
-                    } else if (segments[i].p2 == closestPoint) {
-                        selectedPointIndex = 1;
-                        selectedSegmentIndex = i;
-                        break;
-                    }
-                }
-            }
+            findClosestEndpoint(event->pos(), selectedSegmentIndex, selectedPointIndex);
         } else {
             if (event->button() == Qt::LeftButton) {
-                for (Segment &seg : segments) {
-                    if (!seg.isValid()) {
-                        if (seg.p1.isNull()) {
-                            seg.p1 = event->pos();
-                        } else {
-                            seg.p2 = event->pos();
-                            break;
-                        }
-                        break;
-                    }
+                if (segments.isEmpty() || segments.last().isValid()) {
+                    Segment seg;
+                    seg.p1 = event->pos();
+                    seg.placed = 1;
+                    segments.append(seg);
+                } else {
+                    segments.last().p2 = event->pos();
+                    segments.last().placed = 2;
                 }
                 update();
             }
@@ -126,7 +139,8 @@ protected:
                 segments[selectedSegmentIndex].p2 = event->pos();
             }
 
-            updateIntersection();
+            movedSegmentIndex = selectedSegmentIndex;
+            scheduler.markDirty();
             update();
         }
     }
@@ -135,6 +149,7 @@ protected:
     {
         Q_UNUSED(event);
         if (isInteractiveMode) {
+            scheduler.flush();
             selectedPointIndex = -1;
             selectedSegmentIndex = -1;
         }
@@ -143,10 +158,8 @@ protected:
 private slots:
     void calculateIntersection()
     {
-        if (segments[0].isValid() && segments[1].isValid()) {
-            updateIntersection();
-            update();
-        }
+        updateIntersection();
+        update();
     }
 
     void toggleInteractiveMode(bool enabled)
@@ -154,125 +167,225 @@ private slots:
         isInteractiveMode = enabled;
         calculateButton->setEnabled(!enabled);
 
-        if (enabled && segments[0].isValid() && segments[1].isValid()) {
+        if (enabled) {
             updateIntersection();
             update();
+        } else {
+            partners.clear();
         }
     }
 
-private:
-    struct Segment {
-        QPoint p1, p2;
-        bool isValid() const { return p1 != QPoint() && p2 != QPoint(); }
-        void reset() { p1 = p2 = QPoint(); }
-    };
-
-    QPoint calculateIntersectionPoint(const Segment &s1, const Segment &s2) const
+    void loadSegments()
     {
-        if (!doSegmentsIntersect(s1, s2)) {
-            return QPoint();
-        }
+        QString path = QFileDialog::getOpenFileName(this, "Загрузить отрезки", QString(), "Text files (*.txt);;All files (*)");
+        if (path.isEmpty()) return;
 
-        QPoint p1 = s1.p1;
-        QPoint p2 = s1.p2;
-        QPoint p3 = s2.p1;
-        QPoint p4 = s2.p2;
+        std::ifstream file(path.toLocal8Bit().constData());
+        if (!file) {
+            resultLabel->setText("Не удалось открыть файл");
+            return;
+        }
 
-        int x1 = p1.x(), y1 = p1.y();
-        int x2 = p2.x(), y2 = p2.y();
-        int x3 = p3.x(), y3 = p3.y();
-        int x4 = p4.x(), y4 = p4.y();
+        QVector<Segment> loaded;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream in(line);
+            long long c[4];
+            if (!(in >> c[0] >> c[1] >> c[2] >> c[3])) continue;
 
-        int denom = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
+            bool ok = true;
+            for (int k = 0; k < 4; ++k) {
+                ok = ok && std::llabs(c[k]) < COORDINATE_LIMIT;
+            }
+            if (!ok) continue;
 
-        if (denom == 0) {
-            return QPoint();
+            Segment seg;
+            seg.p1 = QPoint(int(c[0]), int(c[1]));
+            seg.p2 = QPoint(int(c[2]), int(c[3]));
+            seg.placed = 2;
+            loaded.append(seg);
         }
 
-        int x = ((x1 * y2 - y1 * x2) * (x3 - x4) - (x1 - x2) * (x3 * y4 - y3 * x4)) / denom;
-        int y = ((x1 * y2 - y1 * x2) * (y3 - y4) - (y1 - y2) * (x3 * y4 - y3 * x4)) / denom;
-
-        return QPoint(x, y);
+        segments = loaded;
+        updateIntersection();
+        update();
     }
 
-    bool isPointOnSegment(const QPoint &p, const Segment &s) const
+    void clearSegments()
     {
-        return (p.x() <= std::max(s.p1.x(), s.p2.x()) &&
-                p.x() >= std::min(s.p1.x(), s.p2.x()) &&
-                p.y() <= std::max(s.p1.y(), s.p2.y()) &&
-                p.y() >= std::min(s.p1.y(), s.p2.y()));
+        segments.clear();
+        crossings.clear();
+        partners.clear();
+        pairCount = 0;
+        treeProxies.clear();
+        segmentTree.clear();
+        resultLabel->clear();
+        update();
     }
 
-    int orientation(const QPoint &p, const QPoint &q, const QPoint &r) const
+private:
+    // Endpoints are counted as they are placed; (0, 0) is a valid endpoint.
+    struct Segment {
+        QPoint p1, p2;
+        int placed = 0;
+        bool isValid() const { return placed == 2; }
+        void reset() { p1 = p2 = QPoint(); placed = 0; }
+    };
+
+    static geom::IntPoint toGrid(const QPoint &p)
     {
-        int val = (q.y() - p.y()) * (r.x() - q.x()) - (q.x() - p.x()) * (r.y() - q.y());
-        if (val == 0) return 0;
-        return (val > 0) ? 1 : 2;
+        return geom::IntPoint(p.x(), p.y());
     }
 
-    bool doSegmentsIntersect(const Segment &s1, const Segment &s2) const
+    static uint64_t pairKey(int i, int j)
     {
-        QPoint p1 = s1.p1, q1 = s1.p2;
-        QPoint p2 = s2.p1, q2 = s2.p2;
-
-        int o1 = orientation(p1, q1, p2);
-        int o2 = orientation(p1, q1, q2);
-        int o3 = orientation(p2, q2, p1);
-        int o4 = orientation(p2, q2, q1);
-
-        if (o1 != o2 && o3 != o4) {
-            return true;
-        }
-
-        if (o1 == 0 && isPointOnSegment(p2, s1)) return true;
-        if (o2 == 0 && isPointOnSegment(q2, s1)) return true;
-        if (o3 == 0 && isPointOnSegment(p1, s2)) return true;
-        if (o4 == 0 && isPointOnSegment(q1, s2)) return true;
+        return (uint64_t(std::min(i, j)) << 32) | uint32_t(std::max(i, j));
+    }
 
-        return false;
+    geom::IntBox segmentBox(int i) const
+    {
+        return geom::IntBox(toGrid(segments[i].p1), toGrid(segments[i].p2));
     }
 
-    QPoint findClosestPoint(const QPoint &point) const
+    bool findClosestEndpoint(const QPoint &point, int &segmentIndex, int &pointIndex)
     {
         const int MAX_DISTANCE = 15;
 
-        for (const Segment &seg : segments) {
-            if (!seg.isValid()) continue;
+        candidates.clear();
+        geom::IntPoint grid = toGrid(point);
+        segmentTree.query(geom::IntBox(grid, grid).inflated(MAX_DISTANCE), candidates);
 
+        for (uint32_t i : candidates) {
+            const Segment &seg = segments[int(i)];
             if (QLineF(point, seg.p1).length() <= MAX_DISTANCE) {
-                return seg.p1;
+                segmentIndex = int(i);
+                pointIndex = 0;
+                return true;
             }
             if (QLineF(point, seg.p2).length() <= MAX_DISTANCE) {
-                return seg.p2;
+                segmentIndex = int(i);
+                pointIndex = 1;
+                return true;
             }
         }
+        return false;
+    }
 
-        return QPoint();
+    // Pairs are tracked in interactive mode, where a drag updates the count
+    // from them; the points only when they are shown.
+    void addCrossing(int i, int j, const geom::RationalPoint &point)
+    {
+        if (isInteractiveMode) {
+            partners[i].push_back(j);
+            partners[j].push_back(i);
+        }
+        pairCount++;
+        if (countOnlyCheckbox->isChecked()) return;
+
+        geom::Point p = point.toPoint();
+        crossings[pairKey(i, j)] = QPointF(p.x, p.y);
+    }
+
+    void showCount(uint64_t count)
+    {
+        resultLabel->setText(QString("Пересечений: %1").arg(count));
     }
 
+    // Full recomputation with the sweep; also rebuilds the broad phase tree.
+    // Only interactive mode keeps the pairs, so a plain count stores nothing
+    // per intersection; switching to interactive mode recomputes them.
     void updateIntersection()
     {
-        intersectionPoints.clear();
+        crossings.clear();
+        partners.clear();
+        if (isInteractiveMode) partners.resize(segments.size());
+        pairCount = 0;
+        segmentTree.clear();
+        treeProxies.assign(segments.size(), -1);
+
+        std::vector<geom::Segment> valid;
+        std::vector<int> owner;
+        valid.reserve(segments.size());
+        for (int i = 0; i < segments.size(); ++i) {
+            if (segments[i].isValid()) {
+                valid.emplace_back(toGrid(segments[i].p1), toGrid(segments[i].p2));
+                owner.push_back(i);
+                treeProxies[i] = segmentTree.insert(uint32_t(i), segmentBox(i));
+            }
+        }
+
+        if (countOnlyCheckbox->isChecked() && !isInteractiveMode) {
+            pairCount = geom::countSegmentIntersections(valid);
+        } else {
+            geom::visitSegmentIntersections(valid, [&](uint32_t first, uint32_t second, const geom::RationalPoint &point) {
+                addCrossing(owner[first], owner[second], point);
+            });
+        }
+        showCount(pairCount);
+    }
 
-        if (segments[0].isValid() && segments[1].isValid()) {
-            QPoint intersection = calculateIntersectionPoint(segments[0], segments[1]);
-            if (!intersection.isNull()) {
-                intersectionPoints.append(intersection);
+    // Called at most once per frame while dragging. A preview only redraws the
+    // segment and keeps its old crossings; the drop to previews happens when
+    // the last incremental update overran the frame.
+    void recomputeMoved(bool preview)
+    {
+        if (!preview && movedSegmentIndex != -1) moveSegment(movedSegmentIndex);
+    }
+
+    // Rechecks only the segments whose boxes overlap the moved one.
+    void moveSegment(int i)
+    {
+        if (i >= int(partners.size()) || treeProxies[i] < 0) return;
+
+        geom::IntBox box = segmentBox(i);
+        segmentTree.update(treeProxies[i], box);
+
+        for (int j : partners[i]) {
+            crossings.erase(pairKey(i, j));
+            std::vector<int> &other = partners[j];
+            other.erase(std::find(other.begin(), other.end(), i));
+        }
+        pairCount -= partners[i].size();
+        partners[i].clear();
+
+        candidates.clear();
+        segmentTree.query(box, candidates);
+        geom::IntPoint a = toGrid(segments[i].p1), b = toGrid(segments[i].p2);
+        for (uint32_t j : candidates) {
+            if (int(j) == i) continue;
+
+            geom::RationalPoint point;
+            const Segment &other = segments[int(j)];
+            if (geom::exactSegmentIntersection(a, b, toGrid(other.p1), toGrid(other.p2), point) != geom::DISJOINT) {
+                addCrossing(i, int(j), point);
             }
         }
+        showCount(pairCount);
     }
 
     QVector<Segment> segments;
-    QVector<QPoint> intersectionPoints;
+    std::unordered_map<uint64_t, QPointF> crossings;
+    std::vector<std::vector<int>> partners;
+    uint64_t pairCount = 0;
+
+    geom::DynamicBoxTree segmentTree;
+    std::vector<int> treeProxies;
+    std::vector<uint32_t> candidates;
 
     QPushButton *calculateButton;
     QCheckBox *interactiveCheckbox;
+    QCheckBox *countOnlyCheckbox;
+    QLabel *resultLabel;
 
     bool isInteractiveMode;
     int selectedPointIndex;
     int selectedSegmentIndex;
+    int movedSegmentIndex;
+    FrameScheduler scheduler;
 
     static const int POINT_RADIUS = 6;
+    static const int LABEL_LIMIT = 50;
+    static const int COORDINATE_LIMIT = 1 << 30;
 };
 
 int main(int argc, char *argv[])
@@ -8,200 +8,16 @@
 #include <QPushButton>
 #include <QGroupBox>
 #include <QMessageBox>
-#include <QRegularExpression>
+#include <QFileDialog>
 #include <cmath>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 
-class BigNumber {
-private:
-    std::string value;
-    bool negative;
-
-    void removeLeadingZeros() {
-        size_t pos = value.find_first_not_of('0');
-        if (pos == std::string::npos) {
-            value = "0";
-            negative = false;
-        } else {
-            value = value.substr(pos);
-        }
-    }
-
-public:
-    BigNumber() : value("0"), negative(false) {}
-
-    BigNumber(const char* str) {
-        std::string s = str;
-        negative = false;
-
-        if (!s.empty() && s[0] == '-') {
-            negative = true;
-            s = s.substr(1);
-        }
-
-        size_t dotPos = s.find('.');
-        if (dotPos == std::string::npos) {
-            value = s;
-        } else {
-            value = s.substr(0, dotPos) + s.substr(dotPos + 1);
-        }
-
-        removeLeadingZeros();
-        if (value == "0") negative = false;
-    }
-
-    BigNumber(const std::string& str) : BigNumber(str.c_str()) {}
-
-    std::string toString() const {
-        if (value == "0") return "0";
-
-        std::string result;
-        if (negative) result += "-";
-
-        if (value.length() <= 1) {
-            result += value;
-            return result;
-        }
-
-        result += value.substr(0, 1);
-        result += ".";
-        result += value.substr(1);
-
-        return result;
-    }
-
-    int compare(const BigNumber& other) const {
-        if (negative && !other.negative) return -1;
-        if (!negative && other.negative) return 1;
-
-        int len1 = value.length();
-        int len2 = other.value.length();
-
-        if (len1 > len2) return negative ? -1 : 1;
-        if (len1 < len2) return negative ? 1 : -1;
-
-        for (int i = 0; i < len1; i++) {
-            if (value[i] > other.value[i]) return negative ? -1 : 1;
-            if (value[i] < other.value[i]) return negative ? 1 : -1;
-        }
-
-        return 0;
-    }
-
-    bool isZero() const {
-        return value == "0";
-    }
-
-    BigNumber subtract(const BigNumber& other) const {
-        if (negative != other.negative) {
-            BigNumber temp = other;
-            temp.negative = !temp.negative;
-            return add(temp);
-        }
-
-        std::string a = value;
-        std::string b = other.value;
-
-        while (a.length() < b.length()) a = "0" + a;
-        while (b.length() < a.length()) b = "0" + b;
-
-        bool resultNegative = false;
-        if (a < b) {
-            std::swap(a, b);
-            resultNegative = true;
-        }
-
-        std::string result;
-        int borrow = 0;
-
-        for (int i = a.length() - 1; i >= 0; i--) {
-            int digitA = a[i] - '0';
-            int digitB = b[i] - '0';
-
-            int diff = digitA - digitB - borrow;
-            if (diff < 0) {
-                diff += 10;
-                borrow = 1;
-            } else {
-                borrow = 0;
-            }
-
-            result = char(diff + '0') + result;
-        }
-
-        BigNumber res;
-        res.value = result;
-        res.negative = resultNegative;
-        res.removeLeadingZeros();
-        return res;
-    }
-
-    BigNumber add(const BigNumber& other) const {
-        if (negative != other.negative) {
-            BigNumber temp = other;
-            temp.negative = !temp.negative;
-            return subtract(temp);
-        }
-
-        std::string a = value;
-        std::string b = other.value;
-
-        while (a.length() < b.length()) a = "0" + a;
-        while (b.length() < a.length()) b = "0" + b;
-
-        std::string result;
-        int carry = 0;
-
-        for (int i = a.length() - 1; i >= 0; i--) {
-            int sum = (a[i] - '0') + (b[i] - '0') + carry;
-            carry = sum / 10;
-            result = char((sum % 10) + '0') + result;
-        }
-
-        if (carry > 0) {
-            result = char(carry + '0') + result;
-        }
-
-        BigNumber res;
-        res.value = result;
-        res.negative = negative;
-        res.removeLeadingZeros();
-        return res;
-    }
-
-    BigNumber multiply(const BigNumber& other) const {
-        if (isZero() || other.isZero()) return BigNumber("0");
-
-        int len1 = value.length();
-        int len2 = other.value.length();
-        std::vector<int> result(len1 + len2, 0);
-
-        for (int i = len1 - 1; i >= 0; i--) {
-            for (int j = len2 - 1; j >= 0; j--) {
-                int mul = (value[i] - '0') * (other.value[j] - '0');
-                int sum = mul + result[i + j + 1];
-
-                result[i + j + 1] = sum % 10;
-                result[i + j] += sum / 10;
-            }
-        }
-
-        std::string resStr;
-        for (int num : result) {
-            if (!(resStr.empty() && num == 0)) {
-                resStr += char(num + '0');
-            }
-        }
+#include "segment_core.h"
 
-        if (resStr.empty()) resStr = "0";
-
-        BigNumber res;
-        res.value = resStr;
-        res.negative = (negative != other.negative);
-        return res;
-    }
-};
+using geom::Decimal;
 
 class SegmentWidget : public QWidget
 {
@@ -214,6 +30,7 @@ public:
         connect(setSegmentBtn, &QPushButton::clicked, this, &SegmentWidget::setSegmentFromText);
         connect(setPointBtn, &QPushButton::clicked, this, &SegmentWidget::setPointFromText);
         connect(clearBtn, &QPushButton::clicked, this, &SegmentWidget::clearAll);
+        connect(batchBtn, &QPushButton::clicked, this, &SegmentWidget::runBatchFile);
     }
 
 private slots:
@@ -246,6 +63,49 @@ private slots:
         update();
     }
 
+    // Queries are "x1 y1 x2 y2 xp yp" lines; sides are written in input order,
+    // one per line, or as raw int8 values when the output name ends in .bin.
+    void runBatchFile() {
+        QString inputPath = QFileDialog::getOpenFileName(this, "Batch queries", QString(), "Text files (*.txt);;All files (*)");
+        if (inputPath.isEmpty()) return;
+        QString outputPath = QFileDialog::getSaveFileName(this, "Save sides", QString(), "CSV (*.csv);;Binary (*.bin)");
+        if (outputPath.isEmpty()) return;
+
+        std::ifstream input(inputPath.toStdString(), std::ios::binary);
+        std::ofstream output(outputPath.toStdString(), std::ios::binary);
+        if (!input || !output) {
+            QMessageBox::warning(this, "Error", "Cannot open the batch files!");
+            return;
+        }
+        std::ostringstream contents;
+        contents << input.rdbuf();
+        std::string text = contents.str();
+
+        std::string name = outputPath.toStdString();
+        bool binary = name.size() >= 4 && name.compare(name.size() - 4, 4, ".bin") == 0;
+        std::string lines;
+        auto sink = [&](const int8_t* sides, size_t count) {
+            if (binary) {
+                output.write(reinterpret_cast<const char*>(sides), std::streamsize(count));
+                return;
+            }
+            lines.clear();
+            for (size_t i = 0; i < count; i++) {
+                lines += sides[i] < 0 ? "-1\n" : (sides[i] > 0 ? "1\n" : "0\n");
+            }
+            output << lines;
+        };
+
+        geom::PositionBatchStats stats;
+        size_t badLine = geom::batchPointPositions(text.data(), text.data() + text.size(), sink, &stats);
+        if (badLine != 0) {
+            QMessageBox::warning(this, "Error", QString("Line %1 is not x1 y1 x2 y2 xp yp!").arg((unsigned long long)badLine));
+            return;
+        }
+        QMessageBox::information(this, "Batch done", QString("%1 queries, %2 evaluated exactly")
+                                 .arg((unsigned long long)stats.queries).arg((unsigned long long)stats.exact));
+    }
+
     void clearAll() {
         segAx = segAy = segBx = segBy = pointX = pointY = "";
         result = 0;
@@ -304,6 +164,9 @@ private:
         clearBtn = new QPushButton("Clear All");
         groupLayout->addWidget(clearBtn);
 
+        batchBtn = new QPushButton("Batch File...");
+        groupLayout->addWidget(batchBtn);
+
         inputLayout->addWidget(inputGroup);
         inputLayout->addStretch();
 
@@ -329,48 +192,23 @@ private:
             return false;
         }
 
-        QString xStr = parts[0];
-        QString yStr = parts[1];
-
-        QRegularExpression numRegex("^-?\\d*\\.?\\d+$");
-        if (!numRegex.match(xStr).hasMatch() || !numRegex.match(yStr).hasMatch()) {
-            return false;
-        }
+        x = parts[0].toStdString();
+        y = parts[1].toStdString();
+        return isDecimal(x) && isDecimal(y);
+    }
 
-        x = xStr.toStdString();
-        y = yStr.toStdString();
-        return true;
+    static bool isDecimal(const std::string& text) {
+        Decimal value;
+        const char* last = text.data() + text.size();
+        return Decimal::parse(text.data(), last, value) == last;
     }
 
     void calculateExactPosition() {
-        BigNumber x1(segAx.c_str()), y1(segAy.c_str());
-        BigNumber x2(segBx.c_str()), y2(segBy.c_str());
-        BigNumber xp(pointX.c_str()), yp(pointY.c_str());
-
-        BigNumber term1 = (x2.subtract(x1)).multiply(yp.subtract(y1));
-        BigNumber term2 = (y2.subtract(y1)).multiply(xp.subtract(x1));
-        BigNumber cross = term1.subtract(term2);
-
-        if (cross.isZero()) {
-            BigNumber minX = (x1.compare(x2) <= 0) ? x1 : x2;
-            BigNumber maxX = (x1.compare(x2) <= 0) ? x2 : x1;
-            BigNumber minY = (y1.compare(y2) <= 0) ? y1 : y2;
-            BigNumber maxY = (y1.compare(y2) <= 0) ? y2 : y1;
-
-            if (xp.compare(minX) >= 0 && xp.compare(maxX) <= 0 &&
-                yp.compare(minY) >= 0 && yp.compare(maxY) <= 0) {
-                result = 0;
-            } else {
-                result = 1;
-            }
-        } else {
-            BigNumber zero("0");
-            if (cross.compare(zero) > 0) {
-                result = 1;
-            } else {
-                result = -1;
-            }
-        }
+        Decimal x1(segAx), y1(segAy);
+        Decimal x2(segBx), y2(segBy);
+        Decimal xp(pointX), yp(pointY);
+
+        result = geom::exactPointPosition(x1, y1, x2, y2, xp, yp);
 
         resultLabel->setText(QString::number(result));
     }
@@ -434,6 +272,7 @@ protected:
     QPushButton *setSegmentBtn;
     QPushButton *setPointBtn;
     QPushButton *clearBtn;
+    QPushButton *batchBtn;
 };
 
 int main(int argc, char *argv[])
@@ -1,4 +1,4 @@
-#include "polygon_operations.h"
+#include "polygon_ops.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
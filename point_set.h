@@ -0,0 +1,119 @@
+#ifndef POINT_SET_H
+#define POINT_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "point_traits.h"
+
+namespace geom {
+
+// Editable point set stored as separate coordinate arrays plus a selection
+// bitset, so scans and the kernels (through span()) touch only the 16 bytes
+// of coordinates per point.
+//
+// A set can also view coordinate arrays it does not own, such as a mapped
+// scene file; owner keeps them alive and is shared by copies of the set. The
+// first edit copies the arrays into the set's own storage.
+class PointSet {
+public:
+    size_t size() const { return owner ? viewCount : xData.size(); }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return owner ? viewCount : xData.capacity(); }
+
+    void view(const double* xs, const double* ys, size_t count, std::shared_ptr<const void> arrays) {
+        xData.clear();
+        yData.clear();
+        viewX = xs;
+        viewY = ys;
+        viewCount = count;
+        owner = std::move(arrays);
+        selection.assign(words(count), 0);
+    }
+
+    void reserve(size_t count) {
+        detach();
+        xData.reserve(count);
+        yData.reserve(count);
+        selection.reserve(words(count));
+    }
+
+    void clear() {
+        owner.reset();
+        xData.clear();
+        yData.clear();
+        selection.clear();
+    }
+
+    size_t add(double x, double y) {
+        detach();
+        xData.push_back(x);
+        yData.push_back(y);
+        selection.resize(words(xData.size()), 0);
+        return xData.size() - 1;
+    }
+
+    double x(size_t i) const { return xs()[i]; }
+    double y(size_t i) const { return ys()[i]; }
+    void set(size_t i, double x, double y) {
+        detach();
+        xData[i] = x;
+        yData[i] = y;
+    }
+
+    const double* xs() const { return owner ? viewX : xData.data(); }
+    const double* ys() const { return owner ? viewY : yData.data(); }
+    CoordinateSpan<double> span() const { return CoordinateSpan<double>(xs(), ys(), size()); }
+
+    bool selected(size_t i) const { return (selection[i / 64] >> (i % 64)) & 1; }
+    void select(size_t i, bool on = true) {
+        uint64_t bit = uint64_t(1) << (i % 64);
+        selection[i / 64] = on ? selection[i / 64] | bit : selection[i / 64] & ~bit;
+    }
+    void clearSelection() { selection.assign(selection.size(), 0); }
+
+    // Lowest selected index, or size() when nothing is selected.
+    size_t firstSelected() const {
+        for (size_t w = 0; w < selection.size(); w++) {
+            if (selection[w]) return w * 64 + size_t(__builtin_ctzll(selection[w]));
+        }
+        return size();
+    }
+
+    // Lowest index within sqrt(radius2) of (px, py), or size() when none is.
+    size_t findWithin(double px, double py, double radius2) const {
+        const double* xp = xs();
+        const double* yp = ys();
+        for (size_t i = 0, n = size(); i < n; i++) {
+            double dx = xp[i] - px;
+            double dy = yp[i] - py;
+            if (dx * dx + dy * dy <= radius2) return i;
+        }
+        return size();
+    }
+
+private:
+    static size_t words(size_t count) { return (count + 63) / 64; }
+
+    void detach() {
+        if (!owner) return;
+        xData.assign(viewX, viewX + viewCount);
+        yData.assign(viewY, viewY + viewCount);
+        owner.reset();
+    }
+
+    std::vector<double> xData;
+    std::vector<double> yData;
+    std::vector<uint64_t> selection;
+
+    const double* viewX = nullptr;
+    const double* viewY = nullptr;
+    size_t viewCount = 0;
+    std::shared_ptr<const void> owner;
+};
+
+}
+
+#endif
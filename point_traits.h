@@ -0,0 +1,98 @@
+#ifndef POINT_TRAITS_H
+#define POINT_TRAITS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace geom {
+
+// Type the kernels compute cross products of coordinate differences in.
+// Integer coordinates must stay below 2^30 (int32_t, as for IntPoint) or
+// 2^62 (int64_t) in magnitude for those products to be exact.
+template<typename T> struct CoordinateTraits;
+template<> struct CoordinateTraits<float> { typedef double Wide; };
+template<> struct CoordinateTraits<double> { typedef double Wide; };
+template<> struct CoordinateTraits<int32_t> { typedef int64_t Wide; };
+template<> struct CoordinateTraits<int64_t> { typedef __int128 Wide; };
+
+// How to read one point type. The default takes members x and y; types with
+// accessors, such as QPointF, get a specialization next to their users.
+template<typename P>
+struct PointTraits {
+    typedef typename std::remove_cv<decltype(P::x)>::type Scalar;
+    static Scalar x(const P& p) { return p.x; }
+    static Scalar y(const P& p) { return p.y; }
+};
+
+template<typename T>
+struct BasicPoint {
+    T x, y;
+    BasicPoint() : x(0), y(0) {}
+    BasicPoint(T x, T y) : x(x), y(y) {}
+};
+
+// Point sources for the templated kernels: size(), x(i) and y(i) over data
+// owned elsewhere, so nothing is converted up front.
+template<typename P>
+class PointSpan {
+public:
+    typedef typename PointTraits<P>::Scalar Scalar;
+
+    PointSpan(const P* data, size_t count) : data(data), count(count) {}
+
+    size_t size() const { return count; }
+    Scalar x(size_t i) const { return PointTraits<P>::x(data[i]); }
+    Scalar y(size_t i) const { return PointTraits<P>::y(data[i]); }
+
+private:
+    const P* data;
+    size_t count;
+};
+
+template<typename P>
+PointSpan<P> spanOf(const std::vector<P>& points) {
+    return PointSpan<P>(points.data(), points.size());
+}
+
+// Structure-of-arrays source.
+template<typename T>
+class CoordinateSpan {
+public:
+    typedef T Scalar;
+
+    CoordinateSpan(const T* xs, const T* ys, size_t count) : xs(xs), ys(ys), count(count) {}
+
+    size_t size() const { return count; }
+    T x(size_t i) const { return xs[i]; }
+    T y(size_t i) const { return ys[i]; }
+
+private:
+    const T* xs;
+    const T* ys;
+    size_t count;
+};
+
+// orientation() from geometry.h on points of a source: 0 for collinear, 1 for
+// clockwise and 2 for counter-clockwise, evaluated in the wide type.
+template<typename Source>
+int orientation(const Source& s, size_t p, size_t q, size_t r) {
+    typedef typename CoordinateTraits<typename Source::Scalar>::Wide Wide;
+    Wide val = (Wide(s.y(q)) - Wide(s.y(p))) * (Wide(s.x(r)) - Wide(s.x(q))) -
+               (Wide(s.x(q)) - Wide(s.x(p))) * (Wide(s.y(r)) - Wide(s.y(q)));
+    if (val == 0) return 0;
+    return (val > 0) ? 1 : 2;
+}
+
+template<typename Source>
+typename CoordinateTraits<typename Source::Scalar>::Wide squaredDistance(const Source& s, size_t p, size_t q) {
+    typedef typename CoordinateTraits<typename Source::Scalar>::Wide Wide;
+    Wide dx = Wide(s.x(p)) - Wide(s.x(q));
+    Wide dy = Wide(s.y(p)) - Wide(s.y(q));
+    return dx * dx + dy * dy;
+}
+
+}
+
+#endif
@@ -0,0 +1,1208 @@
+#include "polygon_core.h"
+#include "trace.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define POLYGON_CORE_AVX2 1
+#endif
+
+namespace geom {
+
+template<typename Kernel>
+void BasicPolygon<Kernel>::computeConvexHull() {
+    if (points.size() < 3) return;
+
+    int n = points.size();
+    int minIdx = 0;
+    for (int i = 1; i < n; i++) {
+        if (points[i].y < points[minIdx].y ||
+            (points[i].y == points[minIdx].y && points[i].x < points[minIdx].x)) {
+            minIdx = i;
+        }
+    }
+    std::swap(points[0], points[minIdx]);
+
+    TraceScope sort("polygon.hull.sort");
+    PointType pivot = points[0];
+    std::sort(points.begin() + 1, points.end(), [pivot](const PointType& a, const PointType& b) {
+        PointType vecA = a - pivot;
+        PointType vecB = b - pivot;
+        int turn = Kernel::sign(vecA.cross(vecB));
+        if (turn != 0) return turn > 0;
+        return vecA.dist2() < vecB.dist2();
+    });
+    sort.end();
+
+    // The hull stack lives in points[0, size): it never outgrows the prefix
+    // already scanned, so the scan needs no second array.
+    TraceScope scan("polygon.hull.scan");
+    int size = 2;
+    for (int i = 2; i < n; i++) {
+        while (size >= 2) {
+            const PointType& p1 = points[size - 2];
+            const PointType& p2 = points[size - 1];
+            const PointType& p3 = points[i];
+
+            if ((p2 - p1).cross(p3 - p1) <= 0) {
+                size--;
+            } else {
+                break;
+            }
+        }
+        points[size++] = points[i];
+    }
+
+    points.resize(size);
+}
+
+template class BasicPolygon<DoubleKernel>;
+template class BasicPolygon<IntegerKernel>;
+
+IntPoint IntegerKernel::snap(const Point& p, double scale) {
+    auto clamp = [](double v) {
+        double limit = COORDINATE_LIMIT;
+        return int32_t(std::max(-limit, std::min(limit - 1, std::round(v))));
+    };
+    return IntPoint(clamp(p.x * scale), clamp(p.y * scale));
+}
+
+// Differences fit int32, so each product is a 32x32->64 signed multiply and the
+// sign is taken without branches.
+static void orientationsScalar(int32_t abx, int32_t aby, const IntPoint& a,
+                               const IntPoint* points, size_t begin, size_t count, int8_t* signs) {
+    for (size_t i = begin; i < count; i++) {
+        int32_t apx = points[i].x - a.x;
+        int32_t apy = points[i].y - a.y;
+        int64_t cross = int64_t(abx) * apy - int64_t(aby) * apx;
+        signs[i] = int8_t((cross > 0) - (cross < 0));
+    }
+}
+
+#ifdef POLYGON_CORE_AVX2
+// 0x01 in byte k of entry m for every lane k set in the 4-lane movemask m.
+static const uint32_t LANE_BYTES[16] = {
+    0x00000000, 0x00000001, 0x00000100, 0x00000101,
+    0x00010000, 0x00010001, 0x00010100, 0x00010101,
+    0x01000000, 0x01000001, 0x01000100, 0x01000101,
+    0x01010000, 0x01010001, 0x01010100, 0x01010101
+};
+
+// Four points per step: each 64-bit lane holds one point as (x, y), so the
+// differences are taken on int32 and _mm256_mul_epi32 multiplies the low (x)
+// or, after a 32-bit shift, the high (y) half of every lane.
+__attribute__((target("avx2")))
+static void orientationsAvx2(int32_t abx, int32_t aby, const IntPoint& a,
+                             const IntPoint* points, size_t count, int8_t* signs) {
+    static_assert(sizeof(IntPoint) == 8, "IntPoint is two packed int32");
+    const __m256i origin = _mm256_set1_epi64x(int64_t(uint64_t(uint32_t(a.x)) | (uint64_t(uint32_t(a.y)) << 32)));
+    const __m256i edgeX = _mm256_set1_epi64x(abx), edgeY = _mm256_set1_epi64x(aby);
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i ap = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(points + i)), origin);
+        __m256i cross = _mm256_sub_epi64(_mm256_mul_epi32(edgeX, _mm256_srli_epi64(ap, 32)),
+                                         _mm256_mul_epi32(edgeY, ap));
+        unsigned positive = unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(cross, zero))));
+        unsigned negative = unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(zero, cross))));
+        uint32_t packed = LANE_BYTES[positive] | LANE_BYTES[negative] * 0xFF;
+        std::memcpy(signs + i, &packed, sizeof(packed));
+    }
+    orientationsScalar(abx, aby, a, points, i, count, signs);
+}
+#endif
+
+void IntegerKernel::orientations(const IntPoint& a, const IntPoint& b,
+                                 const IntPoint* points, size_t count, int8_t* signs) {
+    const int32_t abx = b.x - a.x;
+    const int32_t aby = b.y - a.y;
+#ifdef POLYGON_CORE_AVX2
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) {
+        orientationsAvx2(abx, aby, a, points, count, signs);
+        return;
+    }
+#endif
+    orientationsScalar(abx, aby, a, points, 0, count, signs);
+}
+
+static double signedArea(const std::vector<Point>& ring) {
+    double area = 0;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        area += ring[j].cross(ring[i]);
+    }
+    return area / 2;
+}
+
+static std::vector<Point> counterClockwiseFromBottom(const std::vector<Point>& points) {
+    std::vector<Point> ring;
+    for (const auto& p : points) {
+        if (ring.empty() || (p - ring.back()).dist2() > 1e-18) {
+            ring.push_back(p);
+        }
+    }
+    while (ring.size() > 1 && (ring.front() - ring.back()).dist2() <= 1e-18) {
+        ring.pop_back();
+    }
+    if (ring.size() >= 3 && signedArea(ring) < 0) {
+        std::reverse(ring.begin(), ring.end());
+    }
+
+    size_t start = 0;
+    for (size_t i = 1; i < ring.size(); i++) {
+        if (ring[i].y < ring[start].y ||
+            (ring[i].y == ring[start].y && ring[i].x < ring[start].x)) {
+            start = i;
+        }
+    }
+    std::rotate(ring.begin(), ring.begin() + start, ring.end());
+    return ring;
+}
+
+// 1 for a convex counter-clockwise ring, -1 for a convex clockwise one and 0
+// for anything else.
+template<typename PointT>
+static int convexTurn(const std::vector<PointT>& ring) {
+    size_t n = ring.size();
+    int turnSign = 0;
+    int xFlips = 0;
+    double prevDx = 0;
+    for (size_t i = 0; i < n; i++) {
+        const PointT& a = ring[i];
+        const PointT& b = ring[(i + 1) % n];
+        const PointT& c = ring[(i + 2) % n];
+        auto cross = (b - a).cross(c - b);
+        int sign = (cross > 0) - (cross < 0);
+        if (sign != 0) {
+            if (turnSign != 0 && sign != turnSign) return false;
+            turnSign = sign;
+        }
+        double dx = double(b.x) - a.x;
+        if (dx != 0) {
+            if (prevDx != 0 && (dx > 0) != (prevDx > 0)) xFlips++;
+            prevDx = dx;
+        }
+    }
+    return xFlips <= 2 ? turnSign : 0;
+}
+
+bool isConvexRing(const std::vector<Point>& ring) {
+    return convexTurn(ring) != 0;
+}
+
+// Both inputs must be convex; otherwise the sum is empty. Edges of the two rings
+// are merged by polar angle starting from their bottom-most vertices, so the sum
+// is built in O(n + m).
+Polygon minkowskiSum(const Polygon& a, const Polygon& b) {
+    Polygon sum;
+    if (a.empty() || b.empty()) return sum;
+    if ((a.size() >= 3 && !isConvexRing(a.points)) || (b.size() >= 3 && !isConvexRing(b.points))) return sum;
+
+    std::vector<Point> p = counterClockwiseFromBottom(a.points);
+    std::vector<Point> q = counterClockwiseFromBottom(b.points);
+    size_t n = p.size();
+    size_t m = q.size();
+    p.push_back(p[0]);
+    p.push_back(p[1 % n]);
+    q.push_back(q[0]);
+    q.push_back(q[1 % m]);
+
+    size_t i = 0, j = 0;
+    while (i < n || j < m) {
+        sum.addPoint(p[i] + q[j]);
+
+        double cross = (p[i + 1] - p[i]).cross(q[j + 1] - q[j]);
+        bool advanceP = i < n && (j == m || cross >= 0);
+        bool advanceQ = j < m && (i == n || cross <= 0);
+        if (advanceP) i++;
+        if (advanceQ) j++;
+    }
+    return sum;
+}
+
+static Point outwardNormal(const Point& from, const Point& to) {
+    Point d = to - from;
+    double len = std::sqrt(d.dist2());
+    return Point(d.y / len, -d.x / len);
+}
+
+struct HalfPlane {
+    Point p, dir;
+    double angle;
+
+    HalfPlane(const Point& p, const Point& dir) : p(p), dir(dir), angle(std::atan2(dir.y, dir.x)) {}
+    bool out(const Point& r) const { return dir.cross(r - p) < -1e-9; }
+};
+
+static Point intersectLines(const HalfPlane& s, const HalfPlane& t) {
+    double alpha = (t.p - s.p).cross(t.dir) / s.dir.cross(t.dir);
+    return s.p + s.dir * alpha;
+}
+
+static std::vector<Point> intersectHalfPlanes(std::vector<HalfPlane> planes) {
+    std::sort(planes.begin(), planes.end(), [](const HalfPlane& a, const HalfPlane& b) {
+        return a.angle < b.angle;
+    });
+
+    std::vector<HalfPlane> dq;
+    size_t front = 0;
+    for (const auto& h : planes) {
+        while (dq.size() - front > 1 && h.out(intersectLines(dq[dq.size() - 1], dq[dq.size() - 2]))) {
+            dq.pop_back();
+        }
+        while (dq.size() - front > 1 && h.out(intersectLines(dq[front], dq[front + 1]))) {
+            front++;
+        }
+        if (dq.size() > front && std::abs(h.dir.cross(dq.back().dir)) < 1e-12) {
+            if (h.dir.dot(dq.back().dir) < 0) return {};
+            if (h.out(dq.back().p)) dq.back() = h;
+            continue;
+        }
+        dq.push_back(h);
+    }
+    while (dq.size() - front > 2 && dq[front].out(intersectLines(dq[dq.size() - 1], dq[dq.size() - 2]))) {
+        dq.pop_back();
+    }
+    while (dq.size() - front > 2 && dq.back().out(intersectLines(dq[front], dq[front + 1]))) {
+        front++;
+    }
+    if (dq.size() - front < 3) return {};
+
+    std::vector<Point> ring;
+    for (size_t i = front; i < dq.size(); i++) {
+        size_t next = (i + 1 < dq.size()) ? i + 1 : front;
+        ring.push_back(intersectLines(dq[i], dq[next]));
+    }
+    if (signedArea(ring) <= 0) return {};
+    return ring;
+}
+
+// Buffers a convex polygon by |distance|: outward when distance > 0, inward otherwise;
+// a non-convex ring gives an empty polygon.
+// Outward corners are joined with a circular arc (chord error <= arcTolerance) or a
+// miter clipped to a bevel beyond miterLimit. Inward offsets of a convex ring have no
+// reflex corners, so they reduce to intersecting the shifted edge half-planes.
+Polygon offsetPolygon(const Polygon& poly, double distance, JoinType join,
+                      double miterLimit, double arcTolerance) {
+    Polygon buffered;
+    std::vector<Point> ring = counterClockwiseFromBottom(poly.points);
+    if (ring.size() < 3 || !isConvexRing(ring)) return buffered;
+
+    size_t n = ring.size();
+    if (distance == 0) {
+        buffered.points = ring;
+        return buffered;
+    }
+
+    if (distance < 0) {
+        std::vector<HalfPlane> planes;
+        for (size_t i = 0; i < n; i++) {
+            const Point& cur = ring[i];
+            const Point& next = ring[(i + 1) % n];
+            planes.emplace_back(cur + outwardNormal(cur, next) * distance, next - cur);
+        }
+        buffered.points = intersectHalfPlanes(planes);
+        return buffered;
+    }
+
+    const double PI = 3.14159265358979323846;
+    double stepAngle = PI / 2;
+    if (arcTolerance > 0 && arcTolerance < distance) {
+        stepAngle = std::min(stepAngle, 2 * std::acos(1 - arcTolerance / distance));
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const Point& prev = ring[(i + n - 1) % n];
+        const Point& cur = ring[i];
+        const Point& next = ring[(i + 1) % n];
+        Point n1 = outwardNormal(prev, cur);
+        Point n2 = outwardNormal(cur, next);
+
+        double sweep = std::atan2(n1.cross(n2), n1.dot(n2));
+        if (sweep <= 1e-12) {
+            buffered.addPoint(cur + n2 * distance);
+            continue;
+        }
+
+        if (join == ROUND_JOIN) {
+            double start = std::atan2(n1.y, n1.x);
+            int steps = std::max(1, int(std::ceil(sweep / stepAngle)));
+            for (int k = 0; k <= steps; k++) {
+                double angle = start + sweep * k / steps;
+                buffered.addPoint(cur + Point(std::cos(angle), std::sin(angle)) * distance);
+            }
+        } else {
+            double cosine = n1.dot(n2);
+            double miterRatio = std::sqrt(2 / (1 + cosine));
+            if (miterRatio <= miterLimit) {
+                buffered.addPoint(cur + (n1 + n2) * (distance / (1 + cosine)));
+            } else {
+                buffered.addPoint(cur + n1 * distance);
+                buffered.addPoint(cur + n2 * distance);
+            }
+        }
+    }
+    return buffered;
+}
+
+bool isPointInsidePolygon(const Point& p, const std::vector<Point>& polygon) {
+    if (polygon.size() < 3) return false;
+
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        if (((polygon[i].y > p.y) != (polygon[j].y > p.y)) &&
+            (p.x < (polygon[j].x - polygon[i].x) * (p.y - polygon[i].y) /
+                           (polygon[j].y - polygon[i].y) + polygon[i].x)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+bool isPointInsidePolygon(const IntPoint& p, const std::vector<IntPoint>& polygon) {
+    if (polygon.size() < 3) return false;
+
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const IntPoint& a = polygon[i];
+        const IntPoint& b = polygon[j];
+        if ((a.y > p.y) != (b.y > p.y)) {
+            int64_t side = (b - a).cross(p - a);
+            if (b.y > a.y ? side > 0 : side < 0) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+bool lineSegmentIntersection(const Point& a1, const Point& a2,
+                             const Point& b1, const Point& b2, Point& result) {
+    Point d1 = a2 - a1;
+    Point d2 = b2 - b1;
+
+    double cross = d1.cross(d2);
+    if (std::abs(cross) < 1e-9) return false;
+
+    double t = (b1 - a1).cross(d2) / cross;
+    double u = (b1 - a1).cross(d1) / cross;
+
+    if (t >= 0 && t <= 1 && u >= 0 && u <= 1) {
+        result = a1 + d1 * t;
+        return true;
+    }
+    return false;
+}
+
+// Exact parameter test on int64 cross products; the crossing point is
+// a1 + d1 * t / den with int128 numerators, rounded once to the grid.
+bool lineSegmentIntersection(const IntPoint& a1, const IntPoint& a2,
+                             const IntPoint& b1, const IntPoint& b2, IntPoint& result) {
+    IntPoint d1 = a2 - a1;
+    IntPoint d2 = b2 - b1;
+
+    int64_t den = d1.cross(d2);
+    if (den == 0) return false;
+
+    int64_t t = (b1 - a1).cross(d2);
+    int64_t u = (b1 - a1).cross(d1);
+    bool inside = den > 0 ? (t >= 0 && t <= den && u >= 0 && u <= den)
+                          : (t <= 0 && t >= den && u <= 0 && u >= den);
+    if (!inside) return false;
+
+    if (den < 0) {
+        den = -den;
+        t = -t;
+    }
+    result = RationalPoint(__int128(a1.x) * den + __int128(d1.x) * t,
+                           __int128(a1.y) * den + __int128(d1.y) * t, den).round();
+    return true;
+}
+
+// Adds to result every point that lies inside ring when inside is true, or
+// outside it otherwise, in input order.
+static void addByContainment(const std::vector<Point>& points, const std::vector<Point>& ring, bool inside,
+                             Polygon& result) {
+    for (const auto& p : points) {
+        if (isPointInsidePolygon(p, ring) == inside) result.addPoint(p);
+    }
+}
+
+// A convex ring is tested edge by edge against all points at once with
+// IntegerKernel::orientations; points on its boundary count as inside. Other
+// rings use the crossing test per point.
+static void addByContainment(const std::vector<IntPoint>& points, const std::vector<IntPoint>& ring, bool inside,
+                             IntPolygon& result) {
+    int turn = ring.size() >= 3 ? convexTurn(ring) : 0;
+    if (turn == 0) {
+        for (const auto& p : points) {
+            if (isPointInsidePolygon(p, ring) == inside) result.addPoint(p);
+        }
+        return;
+    }
+
+    std::vector<int8_t> signs(points.size());
+    std::vector<uint8_t> outside(points.size(), 0);
+    for (size_t j = 0; j < ring.size(); j++) {
+        IntegerKernel::orientations(ring[j], ring[(j + 1) % ring.size()], points.data(), points.size(), signs.data());
+        for (size_t i = 0; i < points.size(); i++) {
+            outside[i] |= uint8_t(signs[i] == -turn);
+        }
+    }
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!outside[i] == inside) result.addPoint(points[i]);
+    }
+}
+
+template<typename Kernel>
+BasicPolygon<Kernel> polygonIntersection(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b) {
+    BasicPolygon<Kernel> result;
+    polygonIntersection(a, b, result);
+    return result;
+}
+
+template<typename Kernel>
+void polygonIntersection(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b, BasicPolygon<Kernel>& result) {
+    typedef typename Kernel::PointType PointType;
+    result.clear();
+    {
+        TraceScope prefilter("polygon.prefilter");
+        if (!BoundingBox(a.points).intersects(BoundingBox(b.points))) return;
+    }
+
+    const std::vector<PointType>& points1 = a.points;
+    const std::vector<PointType>& points2 = b.points;
+
+    TraceScope containment("polygon.containment");
+    addByContainment(points1, points2, true, result);
+    addByContainment(points2, points1, true, result);
+    containment.end();
+
+    TraceScope crossings("polygon.crossings");
+    traceCounter("polygon.edge_pairs", int64_t(points1.size() * points2.size()));
+    for (size_t i = 0; i < points1.size(); i++) {
+        size_t next_i = (i + 1) % points1.size();
+        for (size_t j = 0; j < points2.size(); j++) {
+            size_t next_j = (j + 1) % points2.size();
+
+            PointType intersect;
+            if (lineSegmentIntersection(points1[i], points1[next_i],
+                                        points2[j], points2[next_j], intersect)) {
+                result.addPoint(intersect);
+            }
+        }
+    }
+    crossings.end();
+
+    if (!result.empty()) {
+        result.computeConvexHull();
+    }
+}
+
+template<typename Kernel>
+BasicPolygon<Kernel> polygonUnion(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b) {
+    BasicPolygon<Kernel> result;
+    polygonUnion(a, b, result);
+    return result;
+}
+
+template<typename Kernel>
+void polygonUnion(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b, BasicPolygon<Kernel>& result) {
+    result.clear();
+    result.points.reserve(a.points.size() + b.points.size());
+    result.points.insert(result.points.end(), a.points.begin(), a.points.end());
+    result.points.insert(result.points.end(), b.points.begin(), b.points.end());
+
+    if (!result.empty()) {
+        result.computeConvexHull();
+    }
+}
+
+template<typename Kernel>
+BasicPolygon<Kernel> polygonDifference(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b) {
+    BasicPolygon<Kernel> result;
+    polygonDifference(a, b, result);
+    return result;
+}
+
+template<typename Kernel>
+void polygonDifference(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b, BasicPolygon<Kernel>& result) {
+    typedef typename Kernel::PointType PointType;
+    result.clear();
+    const std::vector<PointType>& points1 = a.points;
+    const std::vector<PointType>& points2 = b.points;
+
+    addByContainment(points1, points2, false, result);
+
+    for (size_t i = 0; i < points1.size(); i++) {
+        size_t next_i = (i + 1) % points1.size();
+        for (size_t j = 0; j < points2.size(); j++) {
+            size_t next_j = (j + 1) % points2.size();
+
+            PointType intersect;
+            if (lineSegmentIntersection(points1[i], points1[next_i],
+                                        points2[j], points2[next_j], intersect)) {
+                result.addPoint(intersect);
+            }
+        }
+    }
+
+    if (!result.empty()) {
+        result.computeConvexHull();
+    }
+}
+
+template Polygon polygonIntersection(const Polygon& a, const Polygon& b);
+template Polygon polygonUnion(const Polygon& a, const Polygon& b);
+template Polygon polygonDifference(const Polygon& a, const Polygon& b);
+template IntPolygon polygonIntersection(const IntPolygon& a, const IntPolygon& b);
+template IntPolygon polygonUnion(const IntPolygon& a, const IntPolygon& b);
+template IntPolygon polygonDifference(const IntPolygon& a, const IntPolygon& b);
+template void polygonIntersection(const Polygon& a, const Polygon& b, Polygon& result);
+template void polygonUnion(const Polygon& a, const Polygon& b, Polygon& result);
+template void polygonDifference(const Polygon& a, const Polygon& b, Polygon& result);
+template void polygonIntersection(const IntPolygon& a, const IntPolygon& b, IntPolygon& result);
+template void polygonUnion(const IntPolygon& a, const IntPolygon& b, IntPolygon& result);
+template void polygonDifference(const IntPolygon& a, const IntPolygon& b, IntPolygon& result);
+
+namespace {
+
+enum VertexType { START_VERTEX, END_VERTEX, SPLIT_VERTEX, MERGE_VERTEX, REGULAR_VERTEX };
+
+// Rings are walked with the interior on the left: outer ring counter-clockwise,
+// holes clockwise. Edge i runs from vertex i to next[i].
+struct MonotoneSweep {
+    std::vector<Point> pts;
+    std::vector<uint32_t> next, prev;
+    double sweepY = 0;
+
+    bool above(uint32_t a, uint32_t b) const {
+        return pts[a].y > pts[b].y || (pts[a].y == pts[b].y && pts[a].x < pts[b].x);
+    }
+
+    double edgeX(uint32_t e) const {
+        const Point& a = pts[e];
+        const Point& b = pts[next[e]];
+        if (a.y == b.y) return std::max(a.x, b.x);
+        return a.x + (sweepY - a.y) / (b.y - a.y) * (b.x - a.x);
+    }
+
+    void addRing(const std::vector<Point>& ring, bool counterClockwise) {
+        uint32_t base = pts.size();
+        uint32_t n = ring.size();
+        bool reverse = (signedArea(ring) > 0) != counterClockwise;
+        for (uint32_t i = 0; i < n; i++) {
+            pts.push_back(ring[i]);
+            uint32_t after = base + (i + 1) % n;
+            uint32_t before = base + (i + n - 1) % n;
+            next.push_back(reverse ? before : after);
+            prev.push_back(reverse ? after : before);
+        }
+    }
+
+    VertexType classify(uint32_t v) const {
+        uint32_t p = prev[v], n = next[v];
+        bool convex = (pts[v] - pts[p]).cross(pts[n] - pts[v]) > 0;
+        if (above(v, p) && above(v, n)) return convex ? START_VERTEX : SPLIT_VERTEX;
+        if (above(p, v) && above(n, v)) return convex ? END_VERTEX : MERGE_VERTEX;
+        return REGULAR_VERTEX;
+    }
+};
+
+struct EdgeLess {
+    using is_transparent = void;
+    const MonotoneSweep* sweep;
+
+    bool operator()(uint32_t a, uint32_t b) const {
+        double xa = sweep->edgeX(a), xb = sweep->edgeX(b);
+        if (xa != xb) return xa < xb;
+        return a < b;
+    }
+    bool operator()(uint32_t e, double x) const { return sweep->edgeX(e) < x; }
+    bool operator()(double x, uint32_t e) const { return x < sweep->edgeX(e); }
+};
+
+}
+
+static void triangulateMonotone(const MonotoneSweep& sweep, const std::vector<uint32_t>& face,
+                                std::vector<uint32_t>& triangles) {
+    size_t k = face.size();
+    if (k < 3) return;
+
+    size_t top = 0, bottom = 0;
+    for (size_t i = 1; i < k; i++) {
+        if (sweep.above(face[i], face[top])) top = i;
+        if (sweep.above(face[bottom], face[i])) bottom = i;
+    }
+
+    // Counter-clockwise from the top vertex runs down the left chain.
+    std::vector<std::pair<uint32_t, bool>> order;
+    order.reserve(k);
+    order.emplace_back(face[top], true);
+    size_t left = (top + 1) % k;
+    size_t right = (top + k - 1) % k;
+    while (order.size() < k) {
+        bool takeLeft = right == bottom ||
+                        (left != bottom && sweep.above(face[left], face[right]));
+        if (takeLeft) {
+            order.emplace_back(face[left], true);
+            left = (left + 1) % k;
+        } else {
+            order.emplace_back(face[right], false);
+            right = (right + k - 1) % k;
+        }
+    }
+
+    auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+        if ((sweep.pts[b] - sweep.pts[a]).cross(sweep.pts[c] - sweep.pts[a]) < 0) std::swap(b, c);
+        triangles.push_back(a);
+        triangles.push_back(b);
+        triangles.push_back(c);
+    };
+
+    std::vector<std::pair<uint32_t, bool>> stack;
+    stack.push_back(order[0]);
+    stack.push_back(order[1]);
+    for (size_t j = 2; j + 1 < order.size(); j++) {
+        uint32_t u = order[j].first;
+        bool onLeft = order[j].second;
+        if (onLeft != stack.back().second) {
+            for (size_t i = 0; i + 1 < stack.size(); i++) {
+                addTriangle(u, stack[i].first, stack[i + 1].first);
+            }
+            auto last = stack.back();
+            stack.clear();
+            stack.push_back(last);
+            stack.push_back(order[j]);
+        } else {
+            auto last = stack.back();
+            stack.pop_back();
+            while (!stack.empty()) {
+                const Point& pu = sweep.pts[u];
+                double cross = (sweep.pts[last.first] - pu).cross(sweep.pts[stack.back().first] - pu);
+                if (onLeft ? cross >= 0 : cross <= 0) break;
+                addTriangle(u, last.first, stack.back().first);
+                last = stack.back();
+                stack.pop_back();
+            }
+            stack.push_back(last);
+            stack.push_back(order[j]);
+        }
+    }
+
+    uint32_t u = order.back().first;
+    for (size_t i = 0; i + 1 < stack.size(); i++) {
+        addTriangle(u, stack[i].first, stack[i + 1].first);
+    }
+}
+
+// Splits the polygon into y-monotone pieces with a top-down sweep that adds a
+// diagonal at every split and merge vertex, then triangulates each piece with
+// the linear-time chain stack. Convex outlines without holes take a fan.
+std::vector<uint32_t> triangulatePolygon(const Polygon& poly) {
+    std::vector<uint32_t> triangles;
+    if (poly.points.size() < 3) return triangles;
+
+    if (poly.holes.empty() && isConvexRing(poly.points)) {
+        bool clockwise = signedArea(poly.points) < 0;
+        for (uint32_t i = 1; i + 1 < poly.points.size(); i++) {
+            triangles.push_back(0);
+            triangles.push_back(clockwise ? i + 1 : i);
+            triangles.push_back(clockwise ? i : i + 1);
+        }
+        return triangles;
+    }
+
+    MonotoneSweep sweep;
+    sweep.addRing(poly.points, true);
+    for (const auto& hole : poly.holes) {
+        if (hole.size() >= 3) {
+            sweep.addRing(hole, false);
+        } else {
+            for (const auto& p : hole) {
+                sweep.pts.push_back(p);
+                sweep.next.push_back(sweep.pts.size() - 1);
+                sweep.prev.push_back(sweep.pts.size() - 1);
+            }
+        }
+    }
+
+    uint32_t n = sweep.pts.size();
+    std::vector<uint32_t> events;
+    for (uint32_t v = 0; v < n; v++) {
+        if (sweep.next[v] != v) events.push_back(v);
+    }
+    std::sort(events.begin(), events.end(), [&sweep](uint32_t a, uint32_t b) { return sweep.above(a, b); });
+
+    std::vector<VertexType> types(n, REGULAR_VERTEX);
+    for (uint32_t v : events) {
+        types[v] = sweep.classify(v);
+    }
+
+    typedef std::set<uint32_t, EdgeLess> Status;
+    Status status(EdgeLess{&sweep});
+    std::vector<Status::iterator> position(n, status.end());
+    std::vector<uint32_t> helper(n);
+    std::vector<std::pair<uint32_t, uint32_t>> diagonals;
+
+    auto insertEdge = [&](uint32_t e, uint32_t v) {
+        position[e] = status.insert(e).first;
+        helper[e] = v;
+    };
+    auto removeEdge = [&](uint32_t e, uint32_t v) {
+        if (position[e] == status.end()) return;
+        if (types[helper[e]] == MERGE_VERTEX) diagonals.emplace_back(v, helper[e]);
+        status.erase(position[e]);
+        position[e] = status.end();
+    };
+    auto edgeLeftOf = [&](uint32_t v) -> uint32_t {
+        auto it = status.lower_bound(sweep.pts[v].x);
+        if (it == status.begin()) return n;
+        return *std::prev(it);
+    };
+
+    for (uint32_t v : events) {
+        sweep.sweepY = sweep.pts[v].y;
+        uint32_t p = sweep.prev[v];
+        uint32_t left;
+
+        switch (types[v]) {
+        case START_VERTEX:
+            insertEdge(v, v);
+            break;
+        case END_VERTEX:
+            removeEdge(p, v);
+            break;
+        case SPLIT_VERTEX:
+            left = edgeLeftOf(v);
+            if (left != n) {
+                diagonals.emplace_back(v, helper[left]);
+                helper[left] = v;
+            }
+            insertEdge(v, v);
+            break;
+        case MERGE_VERTEX:
+            removeEdge(p, v);
+            left = edgeLeftOf(v);
+            if (left != n) {
+                if (types[helper[left]] == MERGE_VERTEX) diagonals.emplace_back(v, helper[left]);
+                helper[left] = v;
+            }
+            break;
+        case REGULAR_VERTEX:
+            if (sweep.above(p, v)) {
+                removeEdge(p, v);
+                insertEdge(v, v);
+            } else {
+                left = edgeLeftOf(v);
+                if (left != n) {
+                    if (types[helper[left]] == MERGE_VERTEX) diagonals.emplace_back(v, helper[left]);
+                    helper[left] = v;
+                }
+            }
+            break;
+        }
+    }
+
+    // Half-edge 2k runs along edge k and 2k + 1 against it; ring edges are only
+    // walked forward, since their reverse side is exterior.
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (uint32_t v : events) {
+        edges.emplace_back(v, sweep.next[v]);
+    }
+    size_t ringEdges = edges.size();
+    edges.insert(edges.end(), diagonals.begin(), diagonals.end());
+
+    size_t halfEdges = 2 * edges.size();
+    auto origin = [&edges](size_t h) { return (h & 1) ? edges[h / 2].second : edges[h / 2].first; };
+    auto target = [&edges](size_t h) { return (h & 1) ? edges[h / 2].first : edges[h / 2].second; };
+
+    std::vector<std::vector<size_t>> outgoing(n);
+    for (size_t h = 0; h < halfEdges; h++) {
+        outgoing[origin(h)].push_back(h);
+    }
+    std::vector<size_t> slot(halfEdges);
+    for (uint32_t v = 0; v < n; v++) {
+        auto& list = outgoing[v];
+        std::sort(list.begin(), list.end(), [&](size_t a, size_t b) {
+            Point da = sweep.pts[target(a)] - sweep.pts[v];
+            Point db = sweep.pts[target(b)] - sweep.pts[v];
+            return std::atan2(da.y, da.x) < std::atan2(db.y, db.x);
+        });
+        for (size_t i = 0; i < list.size(); i++) {
+            slot[list[i]] = i;
+        }
+    }
+
+    std::vector<char> visited(halfEdges, 0);
+    for (size_t h = 0; h < halfEdges; h++) {
+        if (h < 2 * ringEdges && (h & 1)) visited[h] = 1;
+    }
+
+    std::vector<uint32_t> face;
+    for (size_t start = 0; start < halfEdges; start++) {
+        if (visited[start]) continue;
+        face.clear();
+        size_t h = start;
+        while (!visited[h]) {
+            visited[h] = 1;
+            face.push_back(origin(h));
+            uint32_t v = target(h);
+            const auto& list = outgoing[v];
+            size_t twin = h ^ 1;
+            h = list[(slot[twin] + list.size() - 1) % list.size()];
+        }
+        triangulateMonotone(sweep, face, triangles);
+    }
+    return triangles;
+}
+
+std::vector<uint32_t> SimplificationIndex::select(double tolerance) const {
+    size_t count = std::partition_point(order.begin(), order.end(), [&](uint32_t i) {
+        return importance[i] >= tolerance;
+    }) - order.begin();
+    std::vector<uint32_t> kept(order.begin(), order.begin() + count);
+    std::sort(kept.begin(), kept.end());
+    return kept;
+}
+
+// Repeatedly drops the vertex spanning the smallest triangle with its current
+// neighbours. Importance is clamped to the largest area removed so far, which
+// keeps the ranking monotone; removal order reversed is the importance order.
+SimplificationIndex visvalingamIndex(const std::vector<Point>& points, bool closed) {
+    SimplificationIndex index;
+    size_t n = points.size();
+    index.importance.assign(n, INFINITY);
+    if (n == 0) return index;
+
+    std::vector<uint32_t> prev(n), next(n);
+    for (size_t i = 0; i < n; i++) {
+        prev[i] = (i + n - 1) % n;
+        next[i] = (i + 1) % n;
+    }
+    auto area = [&](uint32_t i) {
+        return std::abs((points[i] - points[prev[i]]).cross(points[next[i]] - points[prev[i]])) / 2;
+    };
+    auto removable = [&](uint32_t i) { return closed || (i != 0 && i != n - 1); };
+
+    typedef std::pair<double, uint32_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    std::vector<double> current(n, INFINITY);
+    for (uint32_t i = 0; i < n; i++) {
+        if (removable(i)) {
+            current[i] = area(i);
+            heap.emplace(current[i], i);
+        }
+    }
+
+    size_t alive = n;
+    size_t keep = closed ? 3 : 2;
+    double largest = 0;
+    std::vector<uint32_t> removed;
+    while (alive > keep && !heap.empty()) {
+        Entry top = heap.top();
+        heap.pop();
+        uint32_t i = top.second;
+        if (top.first != current[i] || index.importance[i] != INFINITY) continue;
+
+        largest = std::max(largest, top.first);
+        index.importance[i] = largest;
+        removed.push_back(i);
+        alive--;
+
+        next[prev[i]] = next[i];
+        prev[next[i]] = prev[i];
+        for (uint32_t neighbour : {prev[i], next[i]}) {
+            if (removable(neighbour)) {
+                current[neighbour] = area(neighbour);
+                heap.emplace(current[neighbour], neighbour);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (index.importance[i] == INFINITY) index.order.push_back(i);
+    }
+    index.order.insert(index.order.end(), removed.rbegin(), removed.rend());
+    return index;
+}
+
+static double segmentDistance(const Point& p, const Point& a, const Point& b) {
+    Point ab = b - a;
+    double len2 = ab.dist2();
+    double t = len2 > 0 ? std::max(0.0, std::min(1.0, (p - a).dot(ab) / len2)) : 0;
+    return std::sqrt((p - (a + ab * t)).dist2());
+}
+
+// Splits are taken from a max-heap of pending chords, so vertices are ranked
+// in decreasing order as they are found. A vertex is capped by the importance
+// of the split that exposed it. Each chord is scanned once, which is
+// O(n log n) for typical outlines and O(n^2) only for adversarial spirals.
+SimplificationIndex douglasPeuckerIndex(const std::vector<Point>& points, bool closed) {
+    SimplificationIndex index;
+    size_t n = points.size();
+    index.importance.assign(n, INFINITY);
+    if (n == 0) return index;
+
+    struct Chord {
+        double key;
+        uint32_t first, last, split;
+        bool operator<(const Chord& other) const { return key < other.key; }
+    };
+    std::priority_queue<Chord> heap;
+    auto push = [&](uint32_t first, uint32_t last, double cap) {
+        if (last <= first + 1) return;
+        const Point& a = points[first];
+        const Point& b = points[last % n];
+        double best = -1;
+        uint32_t split = first + 1;
+        for (uint32_t i = first + 1; i < last; i++) {
+            double d = segmentDistance(points[i], a, b);
+            if (d > best) {
+                best = d;
+                split = i;
+            }
+        }
+        heap.push({std::min(best, cap), first, last, split});
+    };
+
+    std::vector<uint32_t> anchors;
+    if (closed && n > 1) {
+        uint32_t far = 1;
+        for (uint32_t i = 2; i < n; i++) {
+            if ((points[i] - points[0]).dist2() > (points[far] - points[0]).dist2()) far = i;
+        }
+        anchors = {0, far};
+        push(0, far, INFINITY);
+        push(far, n, INFINITY);
+    } else {
+        anchors = {0, uint32_t(n - 1)};
+        push(0, n - 1, INFINITY);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (i != anchors[0] && i != anchors[1]) index.importance[i] = 0;
+    }
+
+    index.order.push_back(anchors[0]);
+    if (anchors[1] != anchors[0]) index.order.push_back(anchors[1]);
+    while (!heap.empty()) {
+        Chord chord = heap.top();
+        heap.pop();
+        index.importance[chord.split] = chord.key;
+        index.order.push_back(chord.split);
+        push(chord.first, chord.split, chord.key);
+        push(chord.split, chord.last, chord.key);
+    }
+    return index;
+}
+
+Polygon simplifyPolygon(const Polygon& poly, const SimplificationIndex& index, double tolerance) {
+    Polygon simplified;
+    for (uint32_t i : index.select(tolerance)) {
+        simplified.addPoint(poly.points[i]);
+    }
+    simplified.holes = poly.holes;
+    return simplified;
+}
+
+BoundingBox::BoundingBox()
+    : minX(INFINITY), minY(INFINITY), maxX(-INFINITY), maxY(-INFINITY) {}
+
+void BoundingBox::expand(const Point& p) {
+    minX = std::min(minX, p.x);
+    minY = std::min(minY, p.y);
+    maxX = std::max(maxX, p.x);
+    maxY = std::max(maxY, p.y);
+}
+
+void BoundingBox::expand(const BoundingBox& other) {
+    minX = std::min(minX, other.minX);
+    minY = std::min(minY, other.minY);
+    maxX = std::max(maxX, other.maxX);
+    maxY = std::max(maxY, other.maxY);
+}
+
+bool BoundingBox::intersects(const BoundingBox& other) const {
+    return minX <= other.maxX && other.minX <= maxX &&
+           minY <= other.maxY && other.minY <= maxY;
+}
+
+// Sort-Tile-Recursive order: sort by center x, cut into sqrt(P) vertical slices
+// of whole nodes, then sort every slice by center y.
+static void sortTileRecursive(std::vector<size_t>& order, const std::vector<BoundingBox>& boxes,
+                              size_t capacity) {
+    auto centerX = [&boxes](size_t i) { return boxes[i].minX + boxes[i].maxX; };
+    auto centerY = [&boxes](size_t i) { return boxes[i].minY + boxes[i].maxY; };
+
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return centerX(a) < centerX(b); });
+
+    size_t nodeCount = (order.size() + capacity - 1) / capacity;
+    size_t sliceCount = size_t(std::ceil(std::sqrt(double(nodeCount))));
+    size_t sliceSize = capacity * ((nodeCount + sliceCount - 1) / sliceCount);
+
+    for (size_t start = 0; start < order.size(); start += sliceSize) {
+        size_t end = std::min(order.size(), start + sliceSize);
+        std::sort(order.begin() + start, order.begin() + end,
+                  [&](size_t a, size_t b) { return centerY(a) < centerY(b); });
+    }
+}
+
+// std::min binds it by reference, so it needs a definition.
+const size_t PolygonRTree::NODE_CAPACITY;
+
+void PolygonRTree::build(const std::vector<Polygon>& polygons) {
+    nodes.clear();
+    items.clear();
+    itemBoxes.clear();
+
+    for (const auto& poly : polygons) {
+        itemBoxes.emplace_back(poly.points);
+    }
+
+    std::vector<size_t> level;
+    for (size_t i = 0; i < polygons.size(); i++) {
+        if (!polygons[i].empty()) level.push_back(i);
+    }
+    if (level.empty()) return;
+
+    sortTileRecursive(level, itemBoxes, NODE_CAPACITY);
+    std::vector<Node> pending;
+    for (size_t start = 0; start < level.size(); start += NODE_CAPACITY) {
+        Node node;
+        node.leaf = true;
+        node.first = items.size();
+        node.count = std::min(NODE_CAPACITY, level.size() - start);
+        for (size_t k = 0; k < node.count; k++) {
+            items.push_back(level[start + k]);
+            node.box.expand(itemBoxes[level[start + k]]);
+        }
+        pending.push_back(node);
+    }
+
+    while (pending.size() > 1) {
+        std::vector<BoundingBox> boxes;
+        for (const auto& node : pending) {
+            boxes.push_back(node.box);
+        }
+        std::vector<size_t> order(pending.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        sortTileRecursive(order, boxes, NODE_CAPACITY);
+
+        std::vector<Node> parents;
+        for (size_t start = 0; start < order.size(); start += NODE_CAPACITY) {
+            Node parent;
+            parent.leaf = false;
+            parent.first = nodes.size();
+            parent.count = std::min(NODE_CAPACITY, order.size() - start);
+            for (size_t k = 0; k < parent.count; k++) {
+                const Node& child = pending[order[start + k]];
+                parent.box.expand(child.box);
+                nodes.push_back(child);
+            }
+            parents.push_back(parent);
+        }
+        pending.swap(parents);
+    }
+    nodes.push_back(pending[0]);
+}
+
+void PolygonRTree::query(const BoundingBox& box, std::vector<size_t>& hits) const {
+    hits.clear();
+    if (nodes.empty()) return;
+
+    std::vector<size_t> stack;
+    stack.push_back(nodes.size() - 1);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        if (!node.box.intersects(box)) continue;
+
+        for (size_t k = node.first; k < node.first + node.count; k++) {
+            if (!node.leaf) {
+                stack.push_back(k);
+            } else if (itemBoxes[items[k]].intersects(box)) {
+                hits.push_back(items[k]);
+            }
+        }
+    }
+    std::sort(hits.begin(), hits.end());
+}
+
+// Workers claim polygons of the first layer in index order and compute all of
+// their candidate pairs; the calling thread hands completed slots to the sink in
+// the same order. Claims are limited to a window ahead of the sink so memory
+// stays bounded when the sink is slower than the kernels.
+void batchPolygonOperation(const std::vector<Polygon>& first, const std::vector<Polygon>& second,
+                           PolygonKernel kernel,
+                           const std::function<void(const PolygonPairResult&)>& sink,
+                           unsigned threadCount) {
+    if (first.empty() || second.empty()) return;
+
+    PolygonRTree tree;
+    tree.build(second);
+
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    threadCount = std::max(1u, threadCount);
+
+    const size_t window = 64 * size_t(threadCount);
+    std::vector<std::vector<PolygonPairResult>> completed(window);
+    std::vector<char> ready(window, 0);
+    size_t nextIndex = 0;
+    size_t emitted = 0;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    auto worker = [&]() {
+        std::vector<size_t> candidates;
+        while (true) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return nextIndex >= first.size() || nextIndex < emitted + window; });
+                if (nextIndex >= first.size()) return;
+                index = nextIndex++;
+            }
+
+            std::vector<PolygonPairResult> pairs;
+            if (!first[index].empty()) {
+                tree.query(BoundingBox(first[index].points), candidates);
+                for (size_t j : candidates) {
+                    pairs.push_back({index, j, kernel(first[index], second[j])});
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            completed[index % window] = std::move(pairs);
+            ready[index % window] = 1;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; t++) {
+        workers.emplace_back(worker);
+    }
+
+    for (size_t index = 0; index < first.size(); index++) {
+        std::vector<PolygonPairResult> pairs;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return ready[index % window] != 0; });
+            pairs.swap(completed[index % window]);
+            ready[index % window] = 0;
+            emitted = index + 1;
+            changed.notify_all();
+        }
+        for (const auto& pair : pairs) {
+            sink(pair);
+        }
+    }
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+}
@@ -0,0 +1,159 @@
+#ifndef POLYGON_CORE_H
+#define POLYGON_CORE_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include <cstdint>
+#include <queue>
+
+#include "geometry.h"
+
+namespace geom {
+
+struct DoubleKernel {
+    typedef Point PointType;
+    typedef double Scalar;
+
+    static int sign(double value) { return value > 1e-9 ? 1 : (value < -1e-9 ? -1 : 0); }
+};
+
+struct IntegerKernel {
+    typedef IntPoint PointType;
+    typedef int64_t Scalar;
+
+    static const int32_t COORDINATE_LIMIT = 1 << 30;
+
+    static int sign(int64_t value) { return (value > 0) - (value < 0); }
+    static IntPoint snap(const Point& p, double scale);
+    // Sign of (b - a) x (p - a) for every point: 1, -1 or 0. Runs four points
+    // at a time with AVX2 when the CPU has it.
+    static void orientations(const IntPoint& a, const IntPoint& b,
+                             const IntPoint* points, size_t count, int8_t* signs);
+};
+
+template<typename Kernel>
+class BasicPolygon {
+public:
+    typedef typename Kernel::PointType PointType;
+
+    std::vector<PointType> points;
+    std::vector<std::vector<PointType>> holes;
+
+    void addPoint(const PointType& p) { points.push_back(p); }
+    void clear() { points.clear(); holes.clear(); }
+    bool empty() const { return points.empty(); }
+    size_t size() const { return points.size(); }
+
+    void computeConvexHull();
+};
+
+typedef BasicPolygon<DoubleKernel> Polygon;
+typedef BasicPolygon<IntegerKernel> IntPolygon;
+
+enum JoinType { MITER_JOIN, ROUND_JOIN };
+
+// Every turn has the same sign, collinear vertices aside, and the ring winds once.
+bool isConvexRing(const std::vector<Point>& ring);
+
+// Both take convex rings and return an empty polygon for anything else.
+Polygon minkowskiSum(const Polygon& a, const Polygon& b);
+Polygon offsetPolygon(const Polygon& poly, double distance, JoinType join,
+                      double miterLimit = 2.0, double arcTolerance = 0.25);
+
+bool isPointInsidePolygon(const Point& p, const std::vector<Point>& polygon);
+bool isPointInsidePolygon(const IntPoint& p, const std::vector<IntPoint>& polygon);
+bool lineSegmentIntersection(const Point& a1, const Point& a2,
+                             const Point& b1, const Point& b2, Point& result);
+bool lineSegmentIntersection(const IntPoint& a1, const IntPoint& a2,
+                             const IntPoint& b1, const IntPoint& b2, IntPoint& result);
+
+template<typename Kernel>
+BasicPolygon<Kernel> polygonIntersection(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b);
+template<typename Kernel>
+BasicPolygon<Kernel> polygonUnion(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b);
+template<typename Kernel>
+BasicPolygon<Kernel> polygonDifference(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b);
+// Same, into result, whose point capacity is reused.
+template<typename Kernel>
+void polygonIntersection(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b, BasicPolygon<Kernel>& result);
+template<typename Kernel>
+void polygonUnion(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b, BasicPolygon<Kernel>& result);
+template<typename Kernel>
+void polygonDifference(const BasicPolygon<Kernel>& a, const BasicPolygon<Kernel>& b, BasicPolygon<Kernel>& result);
+
+// Indices address the outer ring followed by every hole ring, in input order.
+// Three consecutive indices form one counter-clockwise triangle.
+std::vector<uint32_t> triangulatePolygon(const Polygon& poly);
+
+// Per-vertex importance for level-of-detail extraction. Vertices that must
+// survive every tolerance (ring anchors, polyline endpoints) get infinity.
+struct SimplificationIndex {
+    std::vector<double> importance;
+    std::vector<uint32_t> order;
+
+    std::vector<uint32_t> select(double tolerance) const;
+};
+
+// Visvalingam-Whyatt ranks by effective triangle area, Douglas-Peucker by
+// distance to the chord, so tolerances are in squared and plain units.
+SimplificationIndex visvalingamIndex(const std::vector<Point>& points, bool closed);
+SimplificationIndex douglasPeuckerIndex(const std::vector<Point>& points, bool closed);
+Polygon simplifyPolygon(const Polygon& poly, const SimplificationIndex& index, double tolerance);
+
+struct BoundingBox {
+    double minX, minY, maxX, maxY;
+
+    BoundingBox();
+    template<typename PointT>
+    explicit BoundingBox(const std::vector<PointT>& points) : BoundingBox() {
+        for (const auto& p : points) {
+            expand(Point(p.x, p.y));
+        }
+    }
+    void expand(const Point& p);
+    void expand(const BoundingBox& other);
+    bool intersects(const BoundingBox& other) const;
+};
+
+class PolygonRTree {
+public:
+    void build(const std::vector<Polygon>& polygons);
+    void query(const BoundingBox& box, std::vector<size_t>& hits) const;
+
+private:
+    struct Node {
+        BoundingBox box;
+        size_t first = 0;
+        size_t count = 0;
+        bool leaf = true;
+    };
+
+    static const size_t NODE_CAPACITY = 16;
+
+    std::vector<Node> nodes;
+    std::vector<size_t> items;
+    std::vector<BoundingBox> itemBoxes;
+};
+
+struct PolygonPairResult {
+    size_t first;
+    size_t second;
+    Polygon polygon;
+};
+
+typedef Polygon (*PolygonKernel)(const Polygon& a, const Polygon& b);
+
+void batchPolygonOperation(const std::vector<Polygon>& first, const std::vector<Polygon>& second,
+                           PolygonKernel kernel,
+                           const std::function<void(const PolygonPairResult&)>& sink,
+                           unsigned threadCount = 0);
+
+}
+
+#endif
@@ -1,56 +1,100 @@
 #include "polygon_ops.h"
 
-void Polygon::computeConvexHull() {
-    if (points.size() < 3) return;
-
-    int n = points.size();
-    int minIdx = 0;
-    for (int i = 1; i < n; i++) {
-        if (points[i].y < points[minIdx].y ||
-            (points[i].y == points[minIdx].y && points[i].x < points[minIdx].x)) {
-            minIdx = i;
-        }
+PolygonCanvas::PolygonCanvas(QWidget *parent) : QWidget(parent), mode(FIRST_POLYGON),
+    operation(INTERSECTION), offsetDistance(20), joinType(ROUND_JOIN), showTriangulation(false),
+    lodTolerance(0), lodDirty(true), movingPoint(-1), currentPolygon(-1) {
+    setMouseTracking(true);
+}
+
+void PolygonCanvas::setOperation(Operation op) { operation = op; }
+
+void PolygonCanvas::setOffsetDistance(double distance) {
+    offsetDistance = distance;
+    if (mode == RESULT) {
+        computeResult();
+        lodDirty = true;
+        update();
     }
-    std::swap(points[0], points[minIdx]);
-
-    Point pivot = points[0];
-    std::sort(points.begin() + 1, points.end(), [pivot](const Point& a, const Point& b) {
-        Point vecA = a - pivot;
-        Point vecB = b - pivot;
-        double cross = vecA.cross(vecB);
-        if (std::abs(cross) > 1e-9) return cross > 0;
-        return vecA.dist2() < vecB.dist2();
-    });
+}
+
+void PolygonCanvas::setJoinType(JoinType join) {
+    joinType = join;
+    if (mode == RESULT) {
+        computeResult();
+        lodDirty = true;
+        update();
+    }
+}
 
-    std::vector<Point> hull;
-    hull.push_back(points[0]);
-    hull.push_back(points[1]);
+void PolygonCanvas::setShowTriangulation(bool show) {
+    showTriangulation = show;
+    update();
+}
 
-    for (int i = 2; i < n; i++) {
-        while (hull.size() >= 2) {
-            Point& p1 = hull[hull.size() - 2];
-            Point& p2 = hull[hull.size() - 1];
-            Point& p3 = points[i];
+void PolygonCanvas::setLodTolerance(double tolerance) {
+    lodTolerance = tolerance;
+    update();
+}
 
-            if ((p2 - p1).cross(p3 - p1) <= 0) {
-                hull.pop_back();
-            } else {
-                break;
-            }
+bool PolygonCanvas::loadScene(const std::string& path, std::string& error) {
+    geom::MappedScene scene;
+    if (!scene.open(path, error)) return false;
+
+    Polygon loaded[2];
+    for (size_t i = 0; i < scene.sectionCount(); i++) {
+        const geom::SceneSection& ring = scene.section(i);
+        uint32_t polygon = ring.tag >> 1;
+        if (ring.kind != geom::SCENE_RING || polygon > 1) continue;
+
+        // Polygons own their vertices and the operations edit them, so rings
+        // are copied out of the mapping.
+        const double* xs = scene.xs(ring);
+        const double* ys = scene.ys(ring);
+        std::vector<Point> vertices;
+        vertices.reserve(ring.count);
+        for (size_t j = 0; j < ring.count; j++) {
+            vertices.emplace_back(xs[j], ys[j]);
+        }
+        if (ring.tag & 1) {
+            loaded[polygon].holes.push_back(std::move(vertices));
+        } else {
+            loaded[polygon].points = std::move(vertices);
         }
-        hull.push_back(points[i]);
+    }
+    if (loaded[0].empty()) {
+        error = path + ": no polygon rings";
+        return false;
     }
 
-    points = hull;
+    poly1 = loaded[0];
+    poly2 = loaded[1];
+    result.clear();
+    movingPoint = -1;
+    currentPolygon = -1;
+    if (poly2.empty()) {
+        mode = SECOND_POLYGON;
+    } else {
+        computeResult();
+        mode = RESULT;
+    }
+    lodDirty = true;
+    update();
+    return true;
 }
 
-PolygonCanvas::PolygonCanvas(QWidget *parent) : QWidget(parent), mode(FIRST_POLYGON),
-    movingPoint(-1), currentPolygon(-1), operation(INTERSECTION) {
-    setMouseTracking(true);
+bool PolygonCanvas::saveScene(const std::string& path, std::string& error) {
+    geom::SceneWriter writer;
+    const Polygon* polygons[] = {&poly1, &poly2, &result};
+    for (uint32_t i = 0; i < 3; i++) {
+        if (polygons[i]->empty()) continue;
+        writer.addRing(polygons[i]->points.data(), polygons[i]->points.size(), i, false);
+        for (const auto& hole : polygons[i]->holes) {
+            writer.addRing(hole.data(), hole.size(), i, true);
+        }
+    }
+    return writer.write(path, error);
 }
 
-void PolygonCanvas::setOperation(Operation op) { operation = op; }
-
 void PolygonCanvas::nextPolygon() {
     if (mode == FIRST_POLYGON) {
         poly1.computeConvexHull();
@@ -60,6 +104,7 @@ void PolygonCanvas::nextPolygon() {
         computeResult();
         mode = RESULT;
     }
+    lodDirty = true;
     update();
 }
 
@@ -70,6 +115,7 @@ void PolygonCanvas::reset() {
     mode = FIRST_POLYGON;
     movingPoint = -1;
     currentPolygon = -1;
+    lodDirty = true;
     update();
 }
 
@@ -82,6 +128,7 @@ void PolygonCanvas::mousePressEvent(QMouseEvent *event) {
         for (int i = 0; i < poly1.size(); i++) {
             if (distance2(p, poly1.points[i]) < 100) {
                 poly1.points.erase(poly1.points.begin() + i);
+                lodDirty = true;
                 update();
                 return;
             }
@@ -89,6 +136,7 @@ void PolygonCanvas::mousePressEvent(QMouseEvent *event) {
         for (int i = 0; i < poly2.size(); i++) {
             if (distance2(p, poly2.points[i]) < 100) {
                 poly2.points.erase(poly2.points.begin() + i);
+                lodDirty = true;
                 update();
                 return;
             }
@@ -116,6 +164,7 @@ void PolygonCanvas::mousePressEvent(QMouseEvent *event) {
             }
             poly2.addPoint(p);
         }
+        lodDirty = true;
         update();
     }
 }
@@ -128,6 +177,7 @@ void PolygonCanvas::mouseMoveEvent(QMouseEvent *event) {
         } else if (currentPolygon == 2) {
             poly2.points[movingPoint] = p;
         }
+        lodDirty = true;
         update();
     }
 }
@@ -151,14 +201,29 @@ void PolygonCanvas::paintEvent(QPaintEvent *event) {
 
     painter.fillRect(rect(), Qt::white);
 
+    if (lodTolerance > 0 && lodDirty) {
+        lod1 = visvalingamIndex(poly1.points, true);
+        lod2 = visvalingamIndex(poly2.points, true);
+        lodResult = visvalingamIndex(result.points, true);
+        lodDirty = false;
+    }
+
     if (mode != RESULT) {
-        drawPolygon(painter, poly1, Qt::blue, mode == FIRST_POLYGON);
-        drawPolygon(painter, poly2, Qt::red, mode == SECOND_POLYGON);
+        drawPolygon(painter, poly1, lod1, Qt::blue, mode == FIRST_POLYGON);
+        drawPolygon(painter, poly2, lod2, Qt::red, mode == SECOND_POLYGON);
     } else {
-        drawPolygon(painter, poly1, Qt::blue, false);
-        drawPolygon(painter, poly2, Qt::red, false);
-        drawPolygon(painter, result, Qt::green, true);
+        drawPolygon(painter, poly1, lod1, Qt::blue, false);
+        drawPolygon(painter, poly2, lod2, Qt::red, false);
+        drawPolygon(painter, result, lodResult, Qt::green, true);
+        painter.setPen(Qt::black);
+        painter.drawText(10, height() - 10, QString("Allocations: %1").arg(geom::allocationsCounted() ? QString::number(resultAllocations) : QString("n/a")));
+        if (!resultError.isEmpty()) {
+            painter.setPen(Qt::red);
+            painter.drawText(10, height() - 30, resultError);
+        }
     }
+
+    timing.paint(painter, rect());
 }
 
 double PolygonCanvas::distance2(const Point& a, const Point& b) {
@@ -167,36 +232,67 @@ double PolygonCanvas::distance2(const Point& a, const Point& b) {
     return dx*dx + dy*dy;
 }
 
-void PolygonCanvas::drawPolygon(QPainter& painter, const Polygon& poly, const QColor& color, bool active) {
+void PolygonCanvas::drawPolygon(QPainter& painter, const Polygon& poly, const SimplificationIndex& lod,
+                                const QColor& color, bool active) {
     if (poly.empty()) return;
 
+    std::vector<Point> simplified;
+    const std::vector<Point>* outline = &poly.points;
+    if (lodTolerance > 0 && lod.importance.size() == poly.points.size()) {
+        for (uint32_t i : lod.select(lodTolerance * lodTolerance)) {
+            simplified.push_back(poly.points[i]);
+        }
+        outline = &simplified;
+    }
+
     QPen pen(color);
     pen.setWidth(active ? 3 : 2);
     painter.setPen(pen);
 
-    for (size_t i = 0; i < poly.points.size(); i++) {
-        size_t next = (i + 1) % poly.points.size();
-        painter.drawLine(QPointF(poly.points[i].x, poly.points[i].y),
-                         QPointF(poly.points[next].x, poly.points[next].y));
+    for (size_t i = 0; i < outline->size(); i++) {
+        size_t next = (i + 1) % outline->size();
+        painter.drawLine(QPointF((*outline)[i].x, (*outline)[i].y),
+                         QPointF((*outline)[next].x, (*outline)[next].y));
     }
 
     painter.setBrush(active ? color.lighter(150) : Qt::NoBrush);
-    if (poly.points.size() >= 3) {
+    if (outline->size() >= 3) {
         QPolygonF qpoly;
-        for (const auto& p : poly.points) {
+        for (const auto& p : *outline) {
             qpoly << QPointF(p.x, p.y);
         }
         painter.drawPolygon(qpoly);
     }
 
-    for (const auto& p : poly.points) {
+    if (showTriangulation && poly.points.size() >= 3) {
+        std::vector<Point> vertices = poly.points;
+        for (const auto& hole : poly.holes) {
+            vertices.insert(vertices.end(), hole.begin(), hole.end());
+        }
+        std::vector<uint32_t> triangles = triangulatePolygon(poly);
+
+        painter.setPen(QPen(color.darker(150), 1, Qt::DashLine));
+        painter.setBrush(Qt::NoBrush);
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+            QPolygonF triangle;
+            for (size_t k = 0; k < 3; k++) {
+                triangle << QPointF(vertices[triangles[t + k]].x, vertices[triangles[t + k]].y);
+            }
+            painter.drawPolygon(triangle);
+        }
+    }
+
+    for (const auto& p : *outline) {
         painter.setBrush(color);
         painter.drawEllipse(QPointF(p.x, p.y), 5, 5);
     }
 }
 
 void PolygonCanvas::computeResult() {
+    size_t before = geom::threadAllocations();
+    timing.begin();
     result.clear();
+    resultError.clear();
 
     switch (operation) {
     case INTERSECTION:
@@ -208,115 +304,61 @@ void PolygonCanvas::computeResult() {
     case DIFFERENCE:
         computeDifference();
         break;
+    case MINKOWSKI_SUM:
+        computeMinkowskiSum();
+        break;
+    case OFFSET:
+        computeOffset();
+        break;
     }
+    timing.end();
+    resultAllocations = geom::threadAllocations() - before;
 }
 
-void PolygonCanvas::computeIntersection() {
-    std::vector<Point> points1 = poly1.points;
-    std::vector<Point> points2 = poly2.points;
-
-    for (const auto& p : points1) {
-        if (isPointInsidePolygon(p, points2)) {
-            result.addPoint(p);
-        }
-    }
-
-    for (const auto& p : points2) {
-        if (isPointInsidePolygon(p, points1)) {
-            result.addPoint(p);
-        }
-    }
-
-    for (size_t i = 0; i < points1.size(); i++) {
-        size_t next_i = (i + 1) % points1.size();
-        for (size_t j = 0; j < points2.size(); j++) {
-            size_t next_j = (j + 1) % points2.size();
-
-            Point intersect;
-            if (lineSegmentIntersection(points1[i], points1[next_i],
-                                        points2[j], points2[next_j], intersect)) {
-                result.addPoint(intersect);
-            }
-        }
-    }
+// Drawn polygons are hulled when finished, but loaded rings are kept as they
+// are, and every operation here assumes convex operands.
+static bool convexOperand(const Polygon& poly) {
+    return poly.size() < 3 || isConvexRing(poly.points);
+}
 
-    if (!result.empty()) {
-        result.computeConvexHull();
+void PolygonCanvas::computeIntersection() {
+    if (!convexOperand(poly1) || !convexOperand(poly2)) {
+        resultError = "Intersection needs convex polygons";
+        return;
     }
+    polygonIntersection(poly1, poly2, result);
 }
 
 void PolygonCanvas::computeUnion() {
-    std::vector<Point> allPoints;
-    allPoints.insert(allPoints.end(), poly1.points.begin(), poly1.points.end());
-    allPoints.insert(allPoints.end(), poly2.points.begin(), poly2.points.end());
-
-    for (const auto& p : allPoints) {
-        result.addPoint(p);
-    }
-
-    if (!result.empty()) {
-        result.computeConvexHull();
+    if (!convexOperand(poly1) || !convexOperand(poly2)) {
+        resultError = "Union needs convex polygons";
+        return;
     }
+    polygonUnion(poly1, poly2, result);
 }
 
 void PolygonCanvas::computeDifference() {
-    std::vector<Point> points1 = poly1.points;
-    std::vector<Point> points2 = poly2.points;
-
-    for (const auto& p : points1) {
-        if (!isPointInsidePolygon(p, points2)) {
-            result.addPoint(p);
-        }
-    }
-
-    for (size_t i = 0; i < points1.size(); i++) {
-        size_t next_i = (i + 1) % points1.size();
-        for (size_t j = 0; j < points2.size(); j++) {
-            size_t next_j = (j + 1) % points2.size();
-
-            Point intersect;
-            if (lineSegmentIntersection(points1[i], points1[next_i],
-                                        points2[j], points2[next_j], intersect)) {
-                result.addPoint(intersect);
-            }
-        }
-    }
-
-    if (!result.empty()) {
-        result.computeConvexHull();
+    if (!convexOperand(poly1) || !convexOperand(poly2)) {
+        resultError = "Difference needs convex polygons";
+        return;
     }
+    polygonDifference(poly1, poly2, result);
 }
 
-bool PolygonCanvas::isPointInsidePolygon(const Point& p, const std::vector<Point>& polygon) {
-    if (polygon.size() < 3) return false;
-
-    bool inside = false;
-    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
-        if (((polygon[i].y > p.y) != (polygon[j].y > p.y)) &&
-            (p.x < (polygon[j].x - polygon[i].x) * (p.y - polygon[i].y) /
-                           (polygon[j].y - polygon[i].y) + polygon[i].x)) {
-            inside = !inside;
-        }
+void PolygonCanvas::computeMinkowskiSum() {
+    if (!convexOperand(poly1) || !convexOperand(poly2)) {
+        resultError = "Minkowski sum needs convex polygons";
+        return;
     }
-    return inside;
+    result = minkowskiSum(poly1, poly2);
 }
 
-bool PolygonCanvas::lineSegmentIntersection(const Point& a1, const Point& a2,
-                             const Point& b1, const Point& b2, Point& result) {
-    Point d1 = a2 - a1;
-    Point d2 = b2 - b1;
-
-    double cross = d1.cross(d2);
-    if (std::abs(cross) < 1e-9) return false;
-
-    double t = (b1 - a1).cross(d2) / cross;
-    double u = (b1 - a1).cross(d1) / cross;
-
-    if (t >= 0 && t <= 1 && u >= 0 && u <= 1) {
-        result = a1 + d1 * t;
-        return true;
+void PolygonCanvas::computeOffset() {
+    if (!convexOperand(poly1)) {
+        resultError = "Offset needs a convex first polygon";
+        return;
     }
-    return false;
+    result = offsetPolygon(poly1, offsetDistance, joinType);
 }
 
 MainWindow::MainWindow() {
@@ -335,24 +377,72 @@ MainWindow::MainWindow() {
 
     QPushButton *nextButton = new QPushButton("Next Polygon", this);
     QPushButton *resetButton = new QPushButton("Reset", this);
+    QPushButton *openButton = new QPushButton("Open Scene", this);
+    QPushButton *saveButton = new QPushButton("Save Scene", this);
 
     buttonLayout->addWidget(nextButton);
     buttonLayout->addWidget(resetButton);
+    buttonLayout->addWidget(openButton);
+    buttonLayout->addWidget(saveButton);
 
     QRadioButton *intersectionRadio = new QRadioButton("Intersection", this);
     QRadioButton *unionRadio = new QRadioButton("Union", this);
     QRadioButton *differenceRadio = new QRadioButton("Difference", this);
+    QRadioButton *minkowskiRadio = new QRadioButton("Minkowski Sum", this);
+    QRadioButton *offsetRadio = new QRadioButton("Offset", this);
 
     intersectionRadio->setChecked(true);
 
     buttonLayout->addWidget(intersectionRadio);
     buttonLayout->addWidget(unionRadio);
     buttonLayout->addWidget(differenceRadio);
+    buttonLayout->addWidget(minkowskiRadio);
+    buttonLayout->addWidget(offsetRadio);
 
     mainLayout->addLayout(buttonLayout);
 
+    QHBoxLayout *optionsLayout = new QHBoxLayout();
+
+    QDoubleSpinBox *distanceSpin = new QDoubleSpinBox(this);
+    distanceSpin->setRange(-200, 200);
+    distanceSpin->setValue(20);
+    distanceSpin->setPrefix("Offset distance: ");
+
+    QComboBox *joinCombo = new QComboBox(this);
+    joinCombo->addItem("Round joins");
+    joinCombo->addItem("Miter joins");
+
+    QCheckBox *triangulationCheckbox = new QCheckBox("Show triangulation", this);
+
+    QDoubleSpinBox *lodSpin = new QDoubleSpinBox(this);
+    lodSpin->setRange(0, 100);
+    lodSpin->setValue(0);
+    lodSpin->setPrefix("Simplify: ");
+
+    optionsLayout->addWidget(distanceSpin);
+    optionsLayout->addWidget(joinCombo);
+    optionsLayout->addWidget(triangulationCheckbox);
+    optionsLayout->addWidget(lodSpin);
+    optionsLayout->addStretch();
+
+    mainLayout->addLayout(optionsLayout);
+
     connect(nextButton, &QPushButton::clicked, canvas, &PolygonCanvas::nextPolygon);
     connect(resetButton, &QPushButton::clicked, canvas, &PolygonCanvas::reset);
+    connect(openButton, &QPushButton::clicked, this, [this] {
+        QString path = QFileDialog::getOpenFileName(this, "Open Scene", QString(), "Scenes (*.scene);;All files (*)");
+        std::string error;
+        if (!path.isEmpty() && !canvas->loadScene(path.toLocal8Bit().constData(), error)) {
+            QMessageBox::warning(this, "Error", QString::fromStdString(error));
+        }
+    });
+    connect(saveButton, &QPushButton::clicked, this, [this] {
+        QString path = QFileDialog::getSaveFileName(this, "Save Scene", QString(), "Scenes (*.scene)");
+        std::string error;
+        if (!path.isEmpty() && !canvas->saveScene(path.toLocal8Bit().constData(), error)) {
+            QMessageBox::warning(this, "Error", QString::fromStdString(error));
+        }
+    });
 
     connect(intersectionRadio, &QRadioButton::toggled, this, [this](bool checked) {
         if (checked) canvas->setOperation(PolygonCanvas::INTERSECTION);
@@ -363,4 +453,16 @@ MainWindow::MainWindow() {
     connect(differenceRadio, &QRadioButton::toggled, this, [this](bool checked) {
         if (checked) canvas->setOperation(PolygonCanvas::DIFFERENCE);
     });
+    connect(minkowskiRadio, &QRadioButton::toggled, this, [this](bool checked) {
+        if (checked) canvas->setOperation(PolygonCanvas::MINKOWSKI_SUM);
+    });
+    connect(offsetRadio, &QRadioButton::toggled, this, [this](bool checked) {
+        if (checked) canvas->setOperation(PolygonCanvas::OFFSET);
+    });
+    connect(distanceSpin, &QDoubleSpinBox::valueChanged, canvas, &PolygonCanvas::setOffsetDistance);
+    connect(triangulationCheckbox, &QCheckBox::toggled, canvas, &PolygonCanvas::setShowTriangulation);
+    connect(lodSpin, &QDoubleSpinBox::valueChanged, canvas, &PolygonCanvas::setLodTolerance);
+    connect(joinCombo, &QComboBox::currentIndexChanged, this, [this](int index) {
+        canvas->setJoinType(index == 0 ? ROUND_JOIN : MITER_JOIN);
+    });
 }
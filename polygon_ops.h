@@ -10,47 +10,46 @@
 #include <QCheckBox>
 #include <QRadioButton>
 #include <QButtonGroup>
+#include <QDoubleSpinBox>
+#include <QComboBox>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QFileDialog>
+#include <QMessageBox>
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <stack>
+#include <string>
 
-struct Point {
-    double x, y;
-    Point() : x(0), y(0) {}
-    Point(double x, double y) : x(x), y(y) {}
+#include "polygon_core.h"
+#include "trace_overlay.h"
+#include "scene_file.h"
+#include "alloc_counter.h"
 
-    Point operator+(const Point& other) const { return Point(x + other.x, y + other.y); }
-    Point operator-(const Point& other) const { return Point(x - other.x, y - other.y); }
-    Point operator*(double scalar) const { return Point(x * scalar, y * scalar); }
-    double dot(const Point& other) const { return x * other.x + y * other.y; }
-    double cross(const Point& other) const { return x * other.y - y * other.x; }
-    double dist2() const { return x*x + y*y; }
-};
-
-class Polygon {
-public:
-    std::vector<Point> points;
-
-    void addPoint(const Point& p) { points.push_back(p); }
-    void clear() { points.clear(); }
-    bool empty() const { return points.empty(); }
-    size_t size() const { return points.size(); }
-
-    void computeConvexHull();
-};
+using geom::Point;
+using geom::Polygon;
+using geom::JoinType;
+using geom::MITER_JOIN;
+using geom::ROUND_JOIN;
+using geom::SimplificationIndex;
 
 class PolygonCanvas : public QWidget {
     Q_OBJECT
 
 public:
     enum Mode { FIRST_POLYGON, SECOND_POLYGON, RESULT };
-    enum Operation { INTERSECTION, UNION, DIFFERENCE };
+    enum Operation { INTERSECTION, UNION, DIFFERENCE, MINKOWSKI_SUM, OFFSET };
 
     PolygonCanvas(QWidget *parent = nullptr);
     void setOperation(Operation op);
+    void setOffsetDistance(double distance);
+    void setJoinType(JoinType join);
+    void setShowTriangulation(bool show);
+    void setLodTolerance(double tolerance);
+    // Rings of polygon 0 and 1 become the operands and the result is recomputed;
+    // saving writes the operands and the current result as polygon 2.
+    bool loadScene(const std::string& path, std::string& error);
+    bool saveScene(const std::string& path, std::string& error);
 
 public slots:
     void nextPolygon();
@@ -65,20 +64,32 @@ protected:
 
 private:
     double distance2(const Point& a, const Point& b);
-    void drawPolygon(QPainter& painter, const Polygon& poly, const QColor& color, bool active);
+    void drawPolygon(QPainter& painter, const Polygon& poly, const SimplificationIndex& lod,
+                     const QColor& color, bool active);
     void computeResult();
     void computeIntersection();
     void computeUnion();
     void computeDifference();
-    bool isPointInsidePolygon(const Point& p, const std::vector<Point>& polygon);
-    bool lineSegmentIntersection(const Point& a1, const Point& a2,
-                                 const Point& b1, const Point& b2, Point& result);
+    void computeMinkowskiSum();
+    void computeOffset();
 
     Polygon poly1, poly2, result;
     Mode mode;
     Operation operation;
+    double offsetDistance;
+    JoinType joinType;
+    bool showTriangulation;
+    double lodTolerance;
+    bool lodDirty;
+    SimplificationIndex lod1, lod2, lodResult;
     int movingPoint;
     int currentPolygon;
+    TraceOverlay timing;
+    // Heap allocations of the last computeResult(); the boolean operations
+    // reuse result's capacity, so theirs drop to zero on repeats.
+    size_t resultAllocations = 0;
+    // Why the last result is empty, when an operation rejected its operands.
+    QString resultError;
 };
 
 class MainWindow : public QMainWindow {
@@ -0,0 +1,20 @@
+#ifndef QT_POINT_TRAITS_H
+#define QT_POINT_TRAITS_H
+
+#include <QPointF>
+
+#include "point_traits.h"
+
+namespace geom {
+
+// Lets the kernels read QPointF arrays directly through PointSpan<QPointF>.
+template<>
+struct PointTraits<QPointF> {
+    typedef qreal Scalar;
+    static qreal x(const QPointF& p) { return p.x(); }
+    static qreal y(const QPointF& p) { return p.y(); }
+};
+
+}
+
+#endif
@@ -0,0 +1,284 @@
+#include "scene_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace geom {
+
+static_assert(sizeof(SceneHeader) == 64, "scene header layout");
+static_assert(sizeof(SceneSection) == 32, "scene section layout");
+static_assert(sizeof(Point) == 16 && std::is_standard_layout<Point>::value, "Point is stored as two doubles");
+static_assert(sizeof(Segment) == 16 && std::is_standard_layout<Segment>::value, "Segment is stored as four int32");
+
+static const char SCENE_MAGIC[8] = {'G', 'E', 'O', 'M', 'S', 'C', 'N', '\0'};
+
+// Sections are used in place, so a big-endian host cannot read them.
+static bool littleEndianHost() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+}
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + SCENE_ALIGNMENT - 1) & ~uint64_t(SCENE_ALIGNMENT - 1);
+}
+
+static bool coordinateKind(uint32_t kind) {
+    return kind == SCENE_POINTS || kind == SCENE_RING;
+}
+
+// Bytes per element of each array in a section, 0 for unknown kinds.
+static size_t elementSize(uint32_t kind) {
+    switch (kind) {
+    case SCENE_POINTS:
+    case SCENE_RING:
+        return sizeof(double);
+    case SCENE_SEGMENTS:
+        return sizeof(Segment);
+    case SCENE_TRIANGLES:
+        return 3 * sizeof(uint32_t);
+    default:
+        return 0;
+    }
+}
+
+void SceneWriter::add(uint32_t kind, uint32_t tag, size_t count, const Block* blocks, size_t blockCount) {
+    Pending entry;
+    std::memset(&entry.section, 0, sizeof(entry.section));
+    entry.section.kind = kind;
+    entry.section.tag = tag;
+    entry.section.count = count;
+    for (size_t i = 0; i < blockCount; i++) {
+        entry.blocks[i] = blocks[i];
+    }
+    entry.blockCount = blockCount;
+    pending.push_back(entry);
+}
+
+void SceneWriter::addCoordinates(uint32_t kind, uint32_t tag, const double* xs, const double* ys,
+                                 size_t count, size_t stride) {
+    Block blocks[2] = {{reinterpret_cast<const char*>(xs), sizeof(double), stride},
+                       {reinterpret_cast<const char*>(ys), sizeof(double), stride}};
+    add(kind, tag, count, blocks, 2);
+}
+
+void SceneWriter::addPoints(const double* xs, const double* ys, size_t count) {
+    addCoordinates(SCENE_POINTS, 0, xs, ys, count, sizeof(double));
+}
+
+void SceneWriter::addSegments(const Segment* segments, size_t count) {
+    Block block = {reinterpret_cast<const char*>(segments), sizeof(Segment), sizeof(Segment)};
+    add(SCENE_SEGMENTS, 0, count, &block, 1);
+}
+
+void SceneWriter::addRing(const double* xs, const double* ys, size_t count, uint32_t polygon, bool hole) {
+    addCoordinates(SCENE_RING, polygon << 1 | (hole ? 1 : 0), xs, ys, count, sizeof(double));
+}
+
+void SceneWriter::addRing(const Point* points, size_t count, uint32_t polygon, bool hole) {
+    if (count == 0) {
+        addRing(nullptr, nullptr, 0, polygon, hole);
+        return;
+    }
+    addCoordinates(SCENE_RING, polygon << 1 | (hole ? 1 : 0), &points->x, &points->y, count, sizeof(Point));
+}
+
+void SceneWriter::addTriangles(const uint32_t* indices, size_t triangleCount) {
+    Block block = {reinterpret_cast<const char*>(indices), 3 * sizeof(uint32_t), 3 * sizeof(uint32_t)};
+    add(SCENE_TRIANGLES, 0, triangleCount, &block, 1);
+}
+
+// Writes count elements of a block contiguously, gathering strided ones
+// through a small buffer.
+static void writeBlock(std::ofstream& out, const char* data, size_t size, size_t stride, size_t count) {
+    if (stride == size) {
+        out.write(data, std::streamsize(count * size));
+        return;
+    }
+    char buffer[4096];
+    size_t perChunk = sizeof(buffer) / size;
+    for (size_t first = 0; first < count; first += perChunk) {
+        size_t chunk = std::min(perChunk, count - first);
+        for (size_t i = 0; i < chunk; i++) {
+            std::memcpy(buffer + i * size, data + (first + i) * stride, size);
+        }
+        out.write(buffer, std::streamsize(chunk * size));
+    }
+}
+
+bool SceneWriter::write(const std::string& path, std::string& error) const {
+    if (!littleEndianHost()) {
+        error = "big-endian hosts are not supported";
+        return false;
+    }
+
+    std::vector<SceneSection> table;
+    uint64_t offset = alignUp(sizeof(SceneHeader) + pending.size() * sizeof(SceneSection));
+    for (const Pending& entry : pending) {
+        SceneSection section = entry.section;
+        section.offset = offset;
+        table.push_back(section);
+        for (size_t b = 0; b < entry.blockCount; b++) {
+            offset = alignUp(offset + section.count * entry.blocks[b].size);
+        }
+    }
+
+    SceneHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+    header.version = SCENE_VERSION_MAJOR << 16 | SCENE_VERSION_MINOR;
+    header.sectionCount = uint32_t(table.size());
+    header.fileSize = offset;
+    header.tableOffset = sizeof(SceneHeader);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "cannot create " + path;
+        return false;
+    }
+
+    static const char padding[SCENE_ALIGNMENT] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), std::streamsize(table.size() * sizeof(SceneSection)));
+    uint64_t written = sizeof(header) + table.size() * sizeof(SceneSection);
+    for (size_t i = 0; i < pending.size(); i++) {
+        for (size_t b = 0; b < pending[i].blockCount; b++) {
+            const Block& block = pending[i].blocks[b];
+            out.write(padding, std::streamsize(alignUp(written) - written));
+            writeBlock(out, block.data, block.size, block.stride, size_t(table[i].count));
+            written = alignUp(written) + table[i].count * block.size;
+        }
+    }
+    out.write(padding, std::streamsize(offset - written));
+
+    if (!out.flush()) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+MappedScene::MappedScene() : base(nullptr), size(0), table(nullptr), count(0) {
+#ifdef _WIN32
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+#endif
+}
+
+MappedScene::~MappedScene() {
+    close();
+}
+
+void MappedScene::close() {
+#ifdef _WIN32
+    if (base) UnmapViewOfFile(base);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+#else
+    if (base) munmap(const_cast<char*>(base), size);
+#endif
+    base = nullptr;
+    size = 0;
+    table = nullptr;
+    count = 0;
+}
+
+bool MappedScene::open(const std::string& path, std::string& error) {
+    close();
+    if (!littleEndianHost()) {
+        error = "big-endian hosts are not supported";
+        return false;
+    }
+
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+        error = "cannot open " + path;
+        close();
+        return false;
+    }
+    size = size_t(fileSize.QuadPart);
+    if (size >= sizeof(SceneHeader)) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) base = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) ::close(fd);
+        error = "cannot open " + path;
+        return false;
+    }
+    size = size_t(info.st_size);
+    if (size >= sizeof(SceneHeader)) {
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) base = static_cast<const char*>(view);
+    }
+    ::close(fd);
+#endif
+    if (!base) {
+        error = size < sizeof(SceneHeader) ? path + " is not a scene file" : "cannot map " + path;
+        close();
+        return false;
+    }
+
+    const SceneHeader* header = reinterpret_cast<const SceneHeader*>(base);
+    std::string problem;
+    if (std::memcmp(header->magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0) {
+        problem = "not a scene file";
+    } else if (header->version >> 16 != SCENE_VERSION_MAJOR) {
+        problem = "unsupported version " + std::to_string(header->version >> 16);
+    } else if (header->fileSize != size) {
+        problem = "truncated";
+    } else if (header->tableOffset % alignof(SceneSection) != 0 || header->tableOffset > size ||
+               header->sectionCount > (size - header->tableOffset) / sizeof(SceneSection)) {
+        problem = "bad section table";
+    }
+
+    if (problem.empty()) {
+        table = reinterpret_cast<const SceneSection*>(base + header->tableOffset);
+        count = header->sectionCount;
+        for (size_t i = 0; i < count && problem.empty(); i++) {
+            const SceneSection& s = table[i];
+            size_t element = elementSize(s.kind);
+            if (element == 0) continue;
+            bool inside = s.offset % SCENE_ALIGNMENT == 0 && s.offset <= size && s.count <= (size - s.offset) / element;
+            // count * 8 fits in the file here, so the padded pair cannot overflow.
+            if (inside && coordinateKind(s.kind)) {
+                inside = alignUp(s.count * sizeof(double)) + s.count * sizeof(double) <= size - s.offset;
+            }
+            if (!inside) problem = "section " + std::to_string(i) + " out of bounds";
+        }
+    }
+
+    if (!problem.empty()) {
+        error = path + ": " + problem;
+        close();
+        return false;
+    }
+    return true;
+}
+
+const SceneSection* MappedScene::find(uint32_t kind, size_t from) const {
+    for (size_t i = from; i < count; i++) {
+        if (table[i].kind == kind) return &table[i];
+    }
+    return nullptr;
+}
+
+}
@@ -0,0 +1,129 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+#include "point_traits.h"
+#include "segment_core.h"
+
+namespace geom {
+
+// Binary scene file, little-endian throughout:
+//   SceneHeader (64 bytes), then sectionCount SceneSection entries (32 bytes
+//   each), then the data of every section at a 64-byte aligned offset.
+// Section data has the in-memory layout of the types below, so a mapped file
+// is used in place. Coordinates are stored as an x array and a y array, each
+// 64-byte aligned, which is the layout of PointSet and CoordinateSpan. Readers
+// skip unknown kinds and reject another major version.
+enum SceneSectionKind : uint32_t {
+    SCENE_POINTS = 1,    // double x[count], double y[count]
+    SCENE_SEGMENTS = 2,  // Segment[count]
+    SCENE_RING = 3,      // double x[count], double y[count]; tag is polygon << 1 | isHole
+    SCENE_TRIANGLES = 4, // uint32_t[3 * count], indices into the first point section
+};
+
+const uint32_t SCENE_VERSION_MAJOR = 2;
+const uint32_t SCENE_VERSION_MINOR = 0;
+const size_t SCENE_ALIGNMENT = 64;
+
+struct SceneHeader {
+    char magic[8];         // "GEOMSCN\0"
+    uint32_t version;      // major << 16 | minor
+    uint32_t sectionCount;
+    uint64_t fileSize;
+    uint64_t tableOffset;
+    uint8_t reserved[32];
+};
+
+struct SceneSection {
+    uint32_t kind;
+    uint32_t tag;
+    uint64_t offset;
+    uint64_t count;
+    uint64_t reserved;
+};
+
+// Collects sections and writes them in one pass. Data is referenced, not
+// copied, and must stay alive until write() returns. Point arrays are written
+// as they are; Point rings are split into x and y while writing.
+class SceneWriter {
+public:
+    void addPoints(const double* xs, const double* ys, size_t count);
+    void addSegments(const Segment* segments, size_t count);
+    void addRing(const double* xs, const double* ys, size_t count, uint32_t polygon, bool hole);
+    void addRing(const Point* points, size_t count, uint32_t polygon, bool hole);
+    void addTriangles(const uint32_t* indices, size_t triangleCount);
+
+    bool write(const std::string& path, std::string& error) const;
+
+private:
+    // count elements of size bytes each, stride bytes apart.
+    struct Block {
+        const char* data;
+        size_t size;
+        size_t stride;
+    };
+
+    struct Pending {
+        SceneSection section;
+        Block blocks[2];
+        size_t blockCount;
+    };
+
+    void add(uint32_t kind, uint32_t tag, size_t count, const Block* blocks, size_t blockCount);
+    void addCoordinates(uint32_t kind, uint32_t tag, const double* xs, const double* ys,
+                        size_t count, size_t stride);
+
+    std::vector<Pending> pending;
+};
+
+// Read-only memory map of a scene file. open() validates the header and the
+// section table; the data itself is not touched until it is read.
+class MappedScene {
+public:
+    MappedScene();
+    ~MappedScene();
+
+    MappedScene(const MappedScene&) = delete;
+    MappedScene& operator=(const MappedScene&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    size_t sectionCount() const { return count; }
+    const SceneSection& section(size_t i) const { return table[i]; }
+    // First section of the kind at or after index from, or nullptr.
+    const SceneSection* find(uint32_t kind, size_t from = 0) const;
+
+    // Coordinates of a point or ring section, read straight from the mapping.
+    const double* xs(const SceneSection& s) const { return reinterpret_cast<const double*>(base + s.offset); }
+    const double* ys(const SceneSection& s) const { return xs(s) + coordinateStride(s.count); }
+    CoordinateSpan<double> coordinates(const SceneSection& s) const {
+        return CoordinateSpan<double>(xs(s), ys(s), size_t(s.count));
+    }
+    const Segment* segments(const SceneSection& s) const { return reinterpret_cast<const Segment*>(base + s.offset); }
+    const uint32_t* triangles(const SceneSection& s) const { return reinterpret_cast<const uint32_t*>(base + s.offset); }
+
+    // Doubles from the start of the x array to the start of the y array.
+    static size_t coordinateStride(uint64_t count) {
+        return size_t((count * sizeof(double) + SCENE_ALIGNMENT - 1) / SCENE_ALIGNMENT * SCENE_ALIGNMENT / sizeof(double));
+    }
+
+private:
+    const char* base;
+    size_t size;
+    const SceneSection* table;
+    size_t count;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+};
+
+}
+
+#endif
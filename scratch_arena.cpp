@@ -0,0 +1,58 @@
+#include "scratch_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace geom {
+
+ScratchArena::ScratchArena(size_t blockBytes)
+    : current(0), offset(0), blockBytes(blockBytes), allocations(0) {}
+
+ScratchArena::~ScratchArena() {
+    for (const Block& block : blocks) ::operator delete(block.data);
+}
+
+void ScratchArena::addBlock(size_t size) {
+    blocks.push_back({static_cast<char*>(::operator new(size)), size});
+    allocations++;
+}
+
+void ScratchArena::reset() {
+    if (blocks.size() > 1) {
+        size_t total = capacity();
+        for (const Block& block : blocks) ::operator delete(block.data);
+        blocks.clear();
+        addBlock(total);
+    }
+    current = 0;
+    offset = 0;
+}
+
+size_t ScratchArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks) total += block.size;
+    return total;
+}
+
+void* ScratchArena::do_allocate(size_t bytes, size_t alignment) {
+    while (current < blocks.size()) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(blocks[current].data);
+        uintptr_t aligned = (base + offset + alignment - 1) & ~uintptr_t(alignment - 1);
+        if (aligned + bytes <= base + blocks[current].size) {
+            offset = aligned + bytes - base;
+            return reinterpret_cast<void*>(aligned);
+        }
+        current++;
+        offset = 0;
+    }
+
+    // Geometric growth keeps the block count logarithmic in the run's peak.
+    size_t size = std::max(blocks.empty() ? blockBytes : 2 * blocks.back().size, bytes + alignment);
+    addBlock(size);
+    current = blocks.size() - 1;
+    offset = 0;
+    return do_allocate(bytes, alignment);
+}
+
+}
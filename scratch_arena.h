@@ -0,0 +1,49 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace geom {
+
+// Monotonic memory resource for the temporaries of one computation. Memory is
+// only reclaimed by reset(), which keeps the blocks: a run that needed several
+// blocks leaves them merged into one, so repeating a run of the same size
+// takes nothing from the heap. Not thread-safe; one arena per worker.
+class ScratchArena : public std::pmr::memory_resource {
+public:
+    explicit ScratchArena(size_t blockBytes = 64 * 1024);
+    ~ScratchArena() override;
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    void reset();
+
+    // Blocks taken from the heap since construction.
+    size_t heapAllocations() const { return allocations; }
+    size_t capacity() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void addBlock(size_t size);
+
+    std::vector<Block> blocks;
+    size_t current;
+    size_t offset;
+    size_t blockBytes;
+    size_t allocations;
+};
+
+}
+
+#endif
@@ -0,0 +1,858 @@
+#include "segment_core.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEGMENT_CORE_AVX2 1
+#endif
+
+namespace geom {
+
+namespace {
+
+// Per-segment constants of the side test. The band is evaluated on doubles in
+// exactly the same order by the scalar and the SIMD code, so both agree.
+struct SideBand {
+    IntPoint a;
+    double abx, aby;
+    double crossLimit;
+    double lowDot, highDot;
+    double pointLimit2;
+    bool degenerate;
+
+    SideBand(const IntPoint& a, const IntPoint& b, const SideTolerance& tolerance)
+        : a(a), abx(double(b.x) - a.x), aby(double(b.y) - a.y) {
+        double length2 = abx * abx + aby * aby;
+        degenerate = length2 == 0;
+        crossLimit = tolerance.distance * std::sqrt(length2);
+        lowDot = -tolerance.overhang * length2;
+        highDot = (1 + tolerance.overhang) * length2;
+        pointLimit2 = tolerance.distance * tolerance.distance;
+    }
+
+    int8_t classify(int32_t x, int32_t y) const {
+        double apx = double(x) - a.x;
+        double apy = double(y) - a.y;
+        if (degenerate) return apx * apx + apy * apy <= pointLimit2 ? 0 : -1;
+
+        double cross = abx * apy - aby * apx;
+        double dot = abx * apx + aby * apy;
+        if (std::abs(cross) <= crossLimit && dot >= lowDot && dot <= highDot) return 0;
+        return exactSign(x, y);
+    }
+
+    // Collinear points outside the band count as right, as in the original widget.
+    int8_t exactSign(int32_t x, int32_t y) const {
+        int64_t exact = int64_t(abx) * (int64_t(y) - a.y) - int64_t(aby) * (int64_t(x) - a.x);
+        return exact > 0 ? 1 : -1;
+    }
+};
+
+}
+
+int pointSegmentSide(const IntPoint& a, const IntPoint& b, const IntPoint& p, double tolerance) {
+    return SideBand(a, b, SideTolerance(tolerance)).classify(p.x, p.y);
+}
+
+static void pointSegmentSidesScalar(const SideBand& band, const int32_t* xs, const int32_t* ys,
+                                    size_t begin, size_t count, int8_t* sides) {
+    for (size_t i = begin; i < count; i++) {
+        sides[i] = band.classify(xs[i], ys[i]);
+    }
+}
+
+#ifdef SEGMENT_CORE_AVX2
+// |cross| above this multiple of |abx * apy| + |aby * apx| has the exact sign.
+static const double CROSS_ERROR_BOUND = 3.3306690738754716e-16;
+
+// Four int8 sides packed little-endian, indexed by a 4-lane movemask: 1 or -1
+// per lane, and the bytes to clear for lanes inside the band.
+static const uint32_t SIGN_BYTES[16] = {
+    0xFFFFFFFF, 0xFFFFFF01, 0xFFFF01FF, 0xFFFF0101,
+    0xFF01FFFF, 0xFF01FF01, 0xFF0101FF, 0xFF010101,
+    0x01FFFFFF, 0x01FFFF01, 0x01FF01FF, 0x01FF0101,
+    0x0101FFFF, 0x0101FF01, 0x010101FF, 0x01010101
+};
+static const uint32_t ZERO_BYTES[16] = {
+    0x00000000, 0x000000FF, 0x0000FF00, 0x0000FFFF,
+    0x00FF0000, 0x00FF00FF, 0x00FFFF00, 0x00FFFFFF,
+    0xFF000000, 0xFF0000FF, 0xFF00FF00, 0xFF00FFFF,
+    0xFFFF0000, 0xFFFF00FF, 0xFFFFFF00, 0xFFFFFFFF
+};
+
+// Band test of four points given per lane (a - p) and the segment constants.
+// Returns the four packed sides; lanes the double filter cannot decide are set
+// in uncertain and must be redone with exactSign.
+__attribute__((target("avx2")))
+static inline uint32_t bandSides4(__m256d apx, __m256d apy, __m256d abx, __m256d aby,
+                                  __m256d crossLimit, __m256d lowDot, __m256d highDot, unsigned& uncertain) {
+    const __m256d errorBound = _mm256_set1_pd(CROSS_ERROR_BOUND);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+
+    __m256d left = _mm256_mul_pd(abx, apy);
+    __m256d right = _mm256_mul_pd(aby, apx);
+    __m256d cross = _mm256_sub_pd(left, right);
+    __m256d dot = _mm256_add_pd(_mm256_mul_pd(abx, apx), _mm256_mul_pd(aby, apy));
+
+    __m256d magnitude = _mm256_andnot_pd(signMask, cross);
+    __m256d inBand = _mm256_and_pd(_mm256_cmp_pd(magnitude, crossLimit, _CMP_LE_OQ),
+                                   _mm256_and_pd(_mm256_cmp_pd(dot, lowDot, _CMP_GE_OQ),
+                                                 _mm256_cmp_pd(dot, highDot, _CMP_LE_OQ)));
+    __m256d bound = _mm256_mul_pd(errorBound, _mm256_add_pd(_mm256_andnot_pd(signMask, left),
+                                                            _mm256_andnot_pd(signMask, right)));
+
+    unsigned on = unsigned(_mm256_movemask_pd(inBand));
+    unsigned positive = unsigned(_mm256_movemask_pd(_mm256_cmp_pd(cross, _mm256_setzero_pd(), _CMP_GT_OQ)));
+    uncertain = unsigned(_mm256_movemask_pd(_mm256_cmp_pd(magnitude, bound, _CMP_LE_OQ))) & ~on;
+    return SIGN_BYTES[positive] & ~ZERO_BYTES[on];
+}
+
+__attribute__((target("avx2")))
+static inline __m256d loadPoints4(const int32_t* coords) {
+    return _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(coords)));
+}
+
+__attribute__((target("avx2")))
+static void pointSegmentSidesAvx2(const SideBand& band, const int32_t* xs, const int32_t* ys,
+                                  size_t count, int8_t* sides) {
+    const __m256d ax = _mm256_set1_pd(band.a.x), ay = _mm256_set1_pd(band.a.y);
+    const __m256d abx = _mm256_set1_pd(band.abx), aby = _mm256_set1_pd(band.aby);
+    const __m256d crossLimit = _mm256_set1_pd(band.crossLimit);
+    const __m256d lowDot = _mm256_set1_pd(band.lowDot), highDot = _mm256_set1_pd(band.highDot);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d apx = _mm256_sub_pd(loadPoints4(xs + i), ax);
+        __m256d apy = _mm256_sub_pd(loadPoints4(ys + i), ay);
+        unsigned uncertain;
+        uint32_t packed = bandSides4(apx, apy, abx, aby, crossLimit, lowDot, highDot, uncertain);
+        std::memcpy(sides + i, &packed, sizeof(packed));
+        for (unsigned rest = uncertain; rest != 0; rest &= rest - 1) {
+            unsigned lane = unsigned(__builtin_ctz(rest));
+            sides[i + lane] = band.exactSign(xs[i + lane], ys[i + lane]);
+        }
+    }
+    pointSegmentSidesScalar(band, xs, ys, i, count, sides);
+}
+
+// SideBand constants of every polyline segment as columns, so each lane can
+// gather the ones of its own segment.
+struct SideBandColumns {
+    std::vector<double> ax, ay, abx, aby, crossLimit, lowDot, highDot;
+
+    explicit SideBandColumns(const std::vector<SideBand>& bands) {
+        for (const SideBand& band : bands) {
+            ax.push_back(band.a.x);
+            ay.push_back(band.a.y);
+            abx.push_back(band.abx);
+            aby.push_back(band.aby);
+            crossLimit.push_back(band.crossLimit);
+            lowDot.push_back(band.lowDot);
+            highDot.push_back(band.highDot);
+        }
+    }
+};
+
+// Four points at a time: the slab search runs on all lanes in lockstep (the
+// probe sequence depends only on the vertex count), then the band test runs
+// with each lane's segment constants. Returns how many points were done.
+__attribute__((target("avx2")))
+static size_t polylineSidesAvx2(const std::vector<IntPoint>& vertices, const std::vector<int64_t>& projections,
+                                const IntPoint& direction, const std::vector<SideBand>& bands,
+                                const int32_t* xs, const int32_t* ys, size_t count, int8_t* sides) {
+    SideBandColumns columns(bands);
+    const __m128i originX = _mm_set1_epi32(vertices.front().x), originY = _mm_set1_epi32(vertices.front().y);
+    const __m256i directionX = _mm256_set1_epi64x(direction.x), directionY = _mm256_set1_epi64x(direction.y);
+    const long long* bounds = reinterpret_cast<const long long*>(projections.data());
+    const __m256i one = _mm256_set1_epi64x(1);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i));
+        // (p - front).dot(direction) on int64, wrapping the difference as IntPoint does.
+        __m256i projection = _mm256_add_epi64(
+            _mm256_mul_epi32(_mm256_cvtepi32_epi64(_mm_sub_epi32(x, originX)), directionX),
+            _mm256_mul_epi32(_mm256_cvtepi32_epi64(_mm_sub_epi32(y, originY)), directionY));
+
+        // lower_bound over projections[1, size - 1), as in slab().
+        __m256i base = one;
+        size_t length = projections.size() - 2;
+        if (length > 0) {
+            while (length > 1) {
+                __m256i half = _mm256_set1_epi64x(int64_t(length / 2));
+                __m256i probe = _mm256_i64gather_epi64(bounds, _mm256_add_epi64(base, half), 8);
+                base = _mm256_add_epi64(base, _mm256_and_si256(_mm256_cmpgt_epi64(projection, probe), half));
+                length -= length / 2;
+            }
+            __m256i probe = _mm256_i64gather_epi64(bounds, base, 8);
+            base = _mm256_add_epi64(base, _mm256_and_si256(_mm256_cmpgt_epi64(projection, probe), one));
+        }
+        __m256i segment = _mm256_sub_epi64(base, one);
+
+        __m256d apx = _mm256_sub_pd(_mm256_cvtepi32_pd(x), _mm256_i64gather_pd(columns.ax.data(), segment, 8));
+        __m256d apy = _mm256_sub_pd(_mm256_cvtepi32_pd(y), _mm256_i64gather_pd(columns.ay.data(), segment, 8));
+        unsigned uncertain;
+        uint32_t packed = bandSides4(apx, apy,
+                                     _mm256_i64gather_pd(columns.abx.data(), segment, 8),
+                                     _mm256_i64gather_pd(columns.aby.data(), segment, 8),
+                                     _mm256_i64gather_pd(columns.crossLimit.data(), segment, 8),
+                                     _mm256_i64gather_pd(columns.lowDot.data(), segment, 8),
+                                     _mm256_i64gather_pd(columns.highDot.data(), segment, 8), uncertain);
+        std::memcpy(sides + i, &packed, sizeof(packed));
+        if (uncertain) {
+            int64_t segments[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(segments), segment);
+            for (unsigned rest = uncertain; rest != 0; rest &= rest - 1) {
+                unsigned lane = unsigned(__builtin_ctz(rest));
+                sides[i + lane] = bands[size_t(segments[lane])].exactSign(xs[i + lane], ys[i + lane]);
+            }
+        }
+    }
+    return i;
+}
+#endif
+
+void pointSegmentSides(const IntPoint& a, const IntPoint& b,
+                       const int32_t* xs, const int32_t* ys, size_t count, int8_t* sides,
+                       const SideTolerance& tolerance) {
+    SideBand band(a, b, tolerance);
+#ifdef SEGMENT_CORE_AVX2
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2 && !band.degenerate) {
+        pointSegmentSidesAvx2(band, xs, ys, count, sides);
+        return;
+    }
+#endif
+    pointSegmentSidesScalar(band, xs, ys, 0, count, sides);
+}
+
+bool PolylineSideIndex::build(const std::vector<IntPoint>& polyline) {
+    vertices.clear();
+    projections.clear();
+    if (polyline.size() < 2) return false;
+
+    direction = polyline.back() - polyline.front();
+    for (const IntPoint& v : polyline) {
+        int64_t projection = (v - polyline.front()).dot(direction);
+        if (!projections.empty() && projection <= projections.back()) {
+            projections.clear();
+            return false;
+        }
+        projections.push_back(projection);
+    }
+    vertices = polyline;
+    return true;
+}
+
+// Segment index for p; points before the first or past the last vertex use the
+// end segments. This is lower_bound over projections[1, size - 1) with the
+// comparison turned into a conditional move, since it mispredicts half the time.
+size_t PolylineSideIndex::slab(const IntPoint& p) const {
+    int64_t projection = (p - vertices.front()).dot(direction);
+    const int64_t* base = projections.data() + 1;
+    size_t length = projections.size() - 2;
+    if (length == 0) return 0;
+    while (length > 1) {
+        size_t half = length / 2;
+        base = base[half] < projection ? base + half : base;
+        length -= half;
+    }
+    base += *base < projection;
+    return size_t(base - projections.data()) - 1;
+}
+
+int PolylineSideIndex::side(const IntPoint& p, const SideTolerance& tolerance) const {
+    if (!built()) return 0;
+    size_t i = slab(p);
+    return SideBand(vertices[i], vertices[i + 1], tolerance).classify(p.x, p.y);
+}
+
+void PolylineSideIndex::sides(const int32_t* xs, const int32_t* ys, size_t count, int8_t* out,
+                              const SideTolerance& tolerance) const {
+    if (!built()) {
+        std::fill(out, out + count, int8_t(0));
+        return;
+    }
+
+    // Build rejects repeated vertices, so no band is degenerate.
+    std::vector<SideBand> bands;
+    bands.reserve(vertices.size() - 1);
+    for (size_t s = 0; s + 1 < vertices.size(); s++) {
+        bands.emplace_back(vertices[s], vertices[s + 1], tolerance);
+    }
+
+    size_t i = 0;
+#ifdef SEGMENT_CORE_AVX2
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) i = polylineSidesAvx2(vertices, projections, direction, bands, xs, ys, count, out);
+#endif
+    for (; i < count; i++) {
+        out[i] = bands[slab(IntPoint(xs[i], ys[i]))].classify(xs[i], ys[i]);
+    }
+}
+
+bool isPointOnSegment(const IntPoint& p, const IntPoint& s1, const IntPoint& s2) {
+    return (p.x <= std::max(s1.x, s2.x) &&
+            p.x >= std::min(s1.x, s2.x) &&
+            p.y <= std::max(s1.y, s2.y) &&
+            p.y >= std::min(s1.y, s2.y));
+}
+
+// The decision of doSegmentsIntersect from its four orientations.
+static bool orientationsIntersect(int o1, int o2, int o3, int o4, const IntPoint& p1, const IntPoint& q1,
+                                  const IntPoint& p2, const IntPoint& q2) {
+    if (o1 != o2 && o3 != o4) {
+        return true;
+    }
+
+    if (o1 == 0 && isPointOnSegment(p2, p1, q1)) return true;
+    if (o2 == 0 && isPointOnSegment(q2, p1, q1)) return true;
+    if (o3 == 0 && isPointOnSegment(p1, p2, q2)) return true;
+    if (o4 == 0 && isPointOnSegment(q1, p2, q2)) return true;
+
+    return false;
+}
+
+bool doSegmentsIntersect(const IntPoint& p1, const IntPoint& q1, const IntPoint& p2, const IntPoint& q2) {
+    return orientationsIntersect(orientation(p1, q1, p2), orientation(p1, q1, q2),
+                                 orientation(p2, q2, p1), orientation(p2, q2, q1), p1, q1, p2, q2);
+}
+
+static bool inKernelRange(const IntPoint& p) {
+    return p.x >= -(1 << 30) && p.x < (1 << 30) && p.y >= -(1 << 30) && p.y < (1 << 30);
+}
+
+// orientation() with int64 differences and int128 products, for any int32 input.
+static int wideOrientation(const IntPoint& p, const IntPoint& q, const IntPoint& r) {
+    __int128 val = __int128(int64_t(q.y) - p.y) * (int64_t(r.x) - q.x) -
+                   __int128(int64_t(q.x) - p.x) * (int64_t(r.y) - q.y);
+    if (val == 0) return 0;
+    return (val > 0) ? 1 : 2;
+}
+
+// Pairs with a coordinate outside [-2^30, 2^30) would overflow the int32
+// differences of orientation(), so they take the int128 test.
+static bool pairIntersects(const SegmentArrays& first, const SegmentArrays& second, size_t i) {
+    IntPoint p1(first.x1[i], first.y1[i]), q1(first.x2[i], first.y2[i]);
+    IntPoint p2(second.x1[i], second.y1[i]), q2(second.x2[i], second.y2[i]);
+    if (inKernelRange(p1) && inKernelRange(q1) && inKernelRange(p2) && inKernelRange(q2)) {
+        return doSegmentsIntersect(p1, q1, p2, q2);
+    }
+    return orientationsIntersect(wideOrientation(p1, q1, p2), wideOrientation(p1, q1, q2),
+                                 wideOrientation(p2, q2, p1), wideOrientation(p2, q2, q1), p1, q1, p2, q2);
+}
+
+static size_t segmentPairsIntersectScalar(const SegmentArrays& first, const SegmentArrays& second,
+                                          size_t begin, size_t count, uint64_t* mask) {
+    size_t hits = 0;
+    for (size_t i = begin; i < count; i++) {
+        if (pairIntersects(first, second, i)) {
+            mask[i / 64] |= uint64_t(1) << (i % 64);
+            hits++;
+        }
+    }
+    return hits;
+}
+
+#ifdef SEGMENT_CORE_AVX2
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i loadLanes(const int32_t* values, size_t i) {
+    return _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)));
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i crossLanes(__m256i ux, __m256i uy, __m256i vx, __m256i vy) {
+    return _mm256_sub_epi64(_mm256_mul_epi32(ux, vy), _mm256_mul_epi32(uy, vx));
+}
+
+// Sign bit set in lanes holding a value outside [-2^30, 2^30), where bits 31
+// and 30 differ.
+__attribute__((target("avx2"), always_inline))
+static inline __m128i outOfRangeLanes(const int32_t* values, size_t i) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    return _mm_xor_si128(v, _mm_slli_epi32(v, 1));
+}
+
+// Four pairs per step on exact int64 lanes: coordinate differences fit int32,
+// so _mm256_mul_epi32 gives exact cross products. Lanes where some orientation
+// is zero need the collinear rules, and lanes with a coordinate out of range
+// would overflow; both go to the scalar test.
+__attribute__((target("avx2")))
+static size_t segmentPairsIntersectAvx2(const SegmentArrays& first, const SegmentArrays& second,
+                                        size_t count, uint64_t* mask) {
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t hits = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i ax1 = loadLanes(first.x1, i), ay1 = loadLanes(first.y1, i);
+        __m256i ax2 = loadLanes(first.x2, i), ay2 = loadLanes(first.y2, i);
+        __m256i bx1 = loadLanes(second.x1, i), by1 = loadLanes(second.y1, i);
+        __m256i bx2 = loadLanes(second.x2, i), by2 = loadLanes(second.y2, i);
+
+        __m256i adx = _mm256_sub_epi64(ax2, ax1), ady = _mm256_sub_epi64(ay2, ay1);
+        __m256i bdx = _mm256_sub_epi64(bx2, bx1), bdy = _mm256_sub_epi64(by2, by1);
+
+        __m256i o1 = crossLanes(adx, ady, _mm256_sub_epi64(bx1, ax1), _mm256_sub_epi64(by1, ay1));
+        __m256i o2 = crossLanes(adx, ady, _mm256_sub_epi64(bx2, ax1), _mm256_sub_epi64(by2, ay1));
+        __m256i o3 = crossLanes(bdx, bdy, _mm256_sub_epi64(ax1, bx1), _mm256_sub_epi64(ay1, by1));
+        __m256i o4 = crossLanes(bdx, bdy, _mm256_sub_epi64(ax2, bx1), _mm256_sub_epi64(ay2, by1));
+
+        __m256i crossing = _mm256_and_si256(_mm256_xor_si256(o1, o2), _mm256_xor_si256(o3, o4));
+        __m256i collinear = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi64(o1, zero), _mm256_cmpeq_epi64(o2, zero)),
+                                            _mm256_or_si256(_mm256_cmpeq_epi64(o3, zero), _mm256_cmpeq_epi64(o4, zero)));
+
+        __m128i range = _mm_or_si128(_mm_or_si128(_mm_or_si128(outOfRangeLanes(first.x1, i), outOfRangeLanes(first.y1, i)),
+                                                  _mm_or_si128(outOfRangeLanes(first.x2, i), outOfRangeLanes(first.y2, i))),
+                                     _mm_or_si128(_mm_or_si128(outOfRangeLanes(second.x1, i), outOfRangeLanes(second.y1, i)),
+                                                  _mm_or_si128(outOfRangeLanes(second.x2, i), outOfRangeLanes(second.y2, i))));
+        unsigned undecided = unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(collinear))) |
+                             unsigned(_mm_movemask_ps(_mm_castsi128_ps(range)));
+        unsigned lanes = unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(crossing))) & ~undecided;
+        for (unsigned rest = undecided; rest != 0; rest &= rest - 1) {
+            unsigned lane = unsigned(__builtin_ctz(rest));
+            if (pairIntersects(first, second, i + lane)) lanes |= 1u << lane;
+        }
+
+        mask[i / 64] |= uint64_t(lanes) << (i % 64);
+        hits += size_t(__builtin_popcount(lanes));
+    }
+    return hits + segmentPairsIntersectScalar(first, second, i, count, mask);
+}
+#endif
+
+size_t segmentPairsIntersect(const SegmentArrays& first, const SegmentArrays& second,
+                             size_t count, uint64_t* mask) {
+    std::memset(mask, 0, (count + 63) / 64 * sizeof(uint64_t));
+#ifdef SEGMENT_CORE_AVX2
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) return segmentPairsIntersectAvx2(first, second, count, mask);
+#endif
+    return segmentPairsIntersectScalar(first, second, 0, count, mask);
+}
+
+static bool lexicographicLess(const IntPoint& a, const IntPoint& b) {
+    return a.x != b.x ? a.x < b.x : a.y < b.y;
+}
+
+SegmentRelation exactSegmentIntersection(const IntPoint& p1, const IntPoint& p2,
+                                         const IntPoint& p3, const IntPoint& p4, RationalPoint& result) {
+    IntPoint d1 = p2 - p1;
+    IntPoint d2 = p4 - p3;
+    IntPoint offset = p3 - p1;
+
+    int64_t den = d1.cross(d2);
+    int64_t t = offset.cross(d2);
+    if (den == 0) {
+        if (offset.cross(d1) != 0 || t != 0) return DISJOINT;
+
+        IntPoint lo1 = p1, hi1 = p2, lo2 = p3, hi2 = p4;
+        if (lexicographicLess(hi1, lo1)) std::swap(lo1, hi1);
+        if (lexicographicLess(hi2, lo2)) std::swap(lo2, hi2);
+        const IntPoint& start = lexicographicLess(lo1, lo2) ? lo2 : lo1;
+        const IntPoint& end = lexicographicLess(hi1, hi2) ? hi1 : hi2;
+        if (lexicographicLess(end, start)) return DISJOINT;
+
+        result = RationalPoint(start);
+        return OVERLAPPING;
+    }
+
+    int64_t u = offset.cross(d1);
+    if (den < 0) {
+        den = -den;
+        t = -t;
+        u = -u;
+    }
+    if (t < 0 || t > den || u < 0 || u > den) return DISJOINT;
+
+    if (t == 0 || t == den) {
+        result = RationalPoint(t == 0 ? p1 : p2);
+    } else {
+        result = RationalPoint(__int128(p1.x) * den + __int128(d1.x) * t,
+                               __int128(p1.y) * den + __int128(d1.y) * t, den);
+    }
+    return CROSSING;
+}
+
+bool segmentIntersectionPoint(const IntPoint& p1, const IntPoint& p2,
+                              const IntPoint& p3, const IntPoint& p4, IntPoint& result) {
+    RationalPoint exact;
+    if (exactSegmentIntersection(p1, p2, p3, p4, exact) != CROSSING) {
+        return false;
+    }
+    result = exact.round();
+    return true;
+}
+
+namespace {
+
+int sign(__int128 v) {
+    return (v > 0) - (v < 0);
+}
+
+struct RationalPointGreater {
+    bool operator()(const RationalPoint& p, const RationalPoint& q) const { return compare(p, q) > 0; }
+};
+
+class SegmentSweep {
+public:
+    typedef std::function<void(uint32_t, uint32_t, const RationalPoint&)> Sink;
+
+    explicit SegmentSweep(const std::vector<Segment>& input)
+        : segments(input), status(StatusLess{this}), position(input.size()) {
+        for (Segment& s : segments) {
+            if (s.b.x < s.a.x || (s.b.x == s.a.x && s.b.y < s.a.y)) std::swap(s.a, s.b);
+        }
+    }
+
+    void run(const Sink& report) {
+        struct Endpoint {
+            IntPoint p;
+            uint32_t segment;
+        };
+        std::vector<Endpoint> endpoints;
+        endpoints.reserve(2 * segments.size());
+        for (uint32_t i = 0; i < segments.size(); i++) {
+            endpoints.push_back({segments[i].a, i});
+            if (!(segments[i].a == segments[i].b)) endpoints.push_back({segments[i].b, NONE});
+        }
+        std::sort(endpoints.begin(), endpoints.end(), [](const Endpoint& l, const Endpoint& r) {
+            return l.p.x != r.p.x ? l.p.x < r.p.x : l.p.y < r.p.y;
+        });
+
+        std::vector<uint32_t> upper;
+        size_t next = 0;
+        while (next < endpoints.size() || !crossings.empty()) {
+            if (next < endpoints.size() &&
+                (crossings.empty() || compare(RationalPoint(endpoints[next].p), crossings.top()) <= 0)) {
+                current = RationalPoint(endpoints[next].p);
+            } else {
+                current = crossings.top();
+            }
+
+            upper.clear();
+            while (next < endpoints.size() && compare(RationalPoint(endpoints[next].p), current) == 0) {
+                if (endpoints[next].segment != NONE) upper.push_back(endpoints[next].segment);
+                next++;
+            }
+            while (!crossings.empty() && compare(crossings.top(), current) == 0) {
+                crossings.pop();
+            }
+
+            handleEvent(upper, report);
+        }
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    // Status key standing for the position just below the current event point.
+    static constexpr uint32_t PROBE = UINT32_MAX;
+
+    struct StatusLess {
+        const SegmentSweep* sweep;
+        bool operator()(uint32_t s, uint32_t t) const { return sweep->statusLess(s, t); }
+    };
+
+    IntPoint direction(uint32_t s) const {
+        return segments[s].b - segments[s].a;
+    }
+
+    // -1 when the segment passes below the current event point, 1 above, 0 through it.
+    int side(uint32_t s) const {
+        const Segment& seg = segments[s];
+        int64_t dx = int64_t(seg.b.x) - seg.a.x;
+        int64_t dy = int64_t(seg.b.y) - seg.a.y;
+        __int128 cross = __int128(dx) * (current.yn - __int128(seg.a.y) * current.den) -
+                         __int128(dy) * (current.xn - __int128(seg.a.x) * current.den);
+        return -sign(cross);
+    }
+
+    // Order along the sweep line just after the current event point. Only keys
+    // passing through the event point are ever compared with the stored ones.
+    bool statusLess(uint32_t s, uint32_t t) const {
+        if (s == t) return false;
+        if (s == PROBE) return side(t) >= 0;
+        if (t == PROBE) return side(s) < 0;
+
+        int ss = side(s), st = side(t);
+        if (ss != st) return ss < st;
+        if (ss == 0) {
+            int64_t turn = direction(s).cross(direction(t));
+            if (turn != 0) return turn > 0;
+        }
+        return s < t;
+    }
+
+    void handleEvent(const std::vector<uint32_t>& upper, const Sink& report) {
+        through.clear();
+        for (auto it = status.lower_bound(PROBE); it != status.end() && side(*it) == 0; ++it) {
+            through.push_back(*it);
+        }
+
+        size_t existing = through.size();
+        through.insert(through.end(), upper.begin(), upper.end());
+        for (size_t i = 0; i < through.size(); i++) {
+            for (size_t j = i + 1; j < through.size(); j++) {
+                uint32_t s = through[i], t = through[j];
+                // Collinear overlaps meet at every later event too; report them where one starts.
+                if (j < existing && direction(s).cross(direction(t)) == 0) continue;
+                report(std::min(s, t), std::max(s, t), current);
+            }
+        }
+
+        for (size_t i = 0; i < existing; i++) {
+            status.erase(position[through[i]]);
+        }
+        size_t inserted = 0;
+        for (uint32_t s : through) {
+            const Segment& seg = segments[s];
+            if (seg.a == seg.b || compare(RationalPoint(seg.b), current) == 0) continue;
+            position[s] = status.insert(s).first;
+            inserted++;
+        }
+
+        auto low = status.lower_bound(PROBE);
+        if (inserted == 0) {
+            if (low != status.begin() && low != status.end()) checkCrossing(*std::prev(low), *low);
+            return;
+        }
+        auto high = std::next(low, inserted - 1);
+        if (low != status.begin()) checkCrossing(*std::prev(low), *low);
+        if (std::next(high) != status.end()) checkCrossing(*high, *std::next(high));
+    }
+
+    // Overlaps need no event: the shared endpoints already are events.
+    void checkCrossing(uint32_t s, uint32_t t) {
+        RationalPoint crossing;
+        if (exactSegmentIntersection(segments[s].a, segments[s].b, segments[t].a, segments[t].b, crossing) == CROSSING &&
+            compare(crossing, current) > 0) {
+            crossings.push(crossing);
+        }
+    }
+
+    std::vector<Segment> segments;
+    RationalPoint current;
+    std::set<uint32_t, StatusLess> status;
+    std::vector<std::set<uint32_t, StatusLess>::iterator> position;
+    std::priority_queue<RationalPoint, std::vector<RationalPoint>, RationalPointGreater> crossings;
+    std::vector<uint32_t> through;
+};
+
+}
+
+std::vector<SegmentIntersection> segmentIntersections(const std::vector<Segment>& segments) {
+    std::vector<SegmentIntersection> result;
+    SegmentSweep sweep(segments);
+    sweep.run([&](uint32_t first, uint32_t second, const RationalPoint& p) {
+        result.push_back({first, second, p});
+    });
+    return result;
+}
+
+uint64_t countSegmentIntersections(const std::vector<Segment>& segments) {
+    uint64_t count = 0;
+    SegmentSweep sweep(segments);
+    sweep.run([&](uint32_t, uint32_t, const RationalPoint&) { count++; });
+    return count;
+}
+
+void visitSegmentIntersections(const std::vector<Segment>& segments,
+                               const std::function<void(uint32_t first, uint32_t second,
+                                                        const RationalPoint& point)>& visit) {
+    SegmentSweep sweep(segments);
+    sweep.run(visit);
+}
+
+int exactPointPosition(const BigNumber& x1, const BigNumber& y1,
+                       const BigNumber& x2, const BigNumber& y2,
+                       const BigNumber& xp, const BigNumber& yp) {
+    // Differences of inline-sized coordinates stay inside the objects, and the
+    // cross product sign is taken without forming either product as a BigNumber.
+    BigNumber dx = x2, dy = y2, px = xp, py = yp;
+    dx -= x1;
+    dy -= y1;
+    px -= x1;
+    py -= y1;
+    int cross = BigNumber::determinantSign(dx, dy, px, py);
+
+    if (cross == 0) {
+        bool swapX = x1.compare(x2) > 0;
+        bool swapY = y1.compare(y2) > 0;
+        const BigNumber& minX = swapX ? x2 : x1;
+        const BigNumber& maxX = swapX ? x1 : x2;
+        const BigNumber& minY = swapY ? y2 : y1;
+        const BigNumber& maxY = swapY ? y1 : y2;
+
+        if (xp.compare(minX) >= 0 && xp.compare(maxX) <= 0 &&
+            yp.compare(minY) >= 0 && yp.compare(maxY) <= 0) {
+            return 0;
+        }
+        return 1;
+    }
+    return cross;
+}
+
+int exactPointPosition(const Decimal& x1, const Decimal& y1,
+                       const Decimal& x2, const Decimal& y2,
+                       const Decimal& xp, const Decimal& yp) {
+    int scale = std::max({x1.scale(), y1.scale(), x2.scale(), y2.scale(), xp.scale(), yp.scale()});
+    return exactPointPosition(x1.scaledMantissa(scale), y1.scaledMantissa(scale),
+                              x2.scaledMantissa(scale), y2.scaledMantissa(scale),
+                              xp.scaledMantissa(scale), yp.scaledMantissa(scale));
+}
+
+namespace {
+
+const size_t POSITION_BLOCK_BYTES = 1 << 16;
+
+struct PositionBlock {
+    std::vector<int8_t> sides;
+    size_t lines = 0;
+    size_t badLine = 0;
+    size_t exact = 0;
+};
+
+// Sign of the cross product from correctly rounded inputs. Each input carries
+// a relative error of at most u = 2^-53, which bounds the computed cross product's
+// error by about 6u (|dx| |dy| + ...) over the coordinate magnitudes; 1e-15
+// leaves a margin. Returns 0 when the filter cannot decide.
+int filteredPosition(const double* c) {
+    double dx = c[2] - c[0], dy = c[3] - c[1];
+    double px = c[4] - c[0], py = c[5] - c[1];
+    double cross = dx * py - dy * px;
+    double magnitude = (std::fabs(c[2]) + std::fabs(c[0])) * (std::fabs(c[5]) + std::fabs(c[1])) +
+                       (std::fabs(c[3]) + std::fabs(c[1])) * (std::fabs(c[4]) + std::fabs(c[0]));
+    double bound = 1e-15 * magnitude;
+    if (!(bound < HUGE_VAL)) return 0;
+    if (cross > bound) return 1;
+    if (cross < -bound) return -1;
+    return 0;
+}
+
+void evaluatePositionBlock(const char* p, const char* last, PositionBlock& block) {
+    TraceScope scope("positions.block");
+    Decimal values[6];
+    Decimal* targets[6] = {&values[0], &values[1], &values[2], &values[3], &values[4], &values[5]};
+    double coordinates[6];
+
+    while (p != last) {
+        block.lines++;
+        int fields = parseDecimalLine(p, last, targets, 6);
+        if (fields == 0) continue;
+        if (fields != 6) {
+            block.badLine = block.lines;
+            return;
+        }
+
+        int side = 0;
+        bool cheap = true;
+        for (int k = 0; k < 6 && cheap; k++) cheap = values[k].nearestDouble(coordinates[k]);
+        if (cheap) side = filteredPosition(coordinates);
+        if (side == 0) {
+            side = exactPointPosition(values[0], values[1], values[2], values[3], values[4], values[5]);
+            block.exact++;
+        }
+        block.sides.push_back(int8_t(side));
+    }
+    traceCounter("positions.exact", int64_t(block.exact));
+}
+
+}
+
+// Same scheme as batchPolygonOperation: workers claim blocks of whole lines in
+// order, the calling thread hands finished blocks to the sink, and claims stay
+// within a window ahead of it.
+size_t batchPointPositions(const char* first, const char* last,
+                           const std::function<void(const int8_t* sides, size_t count)>& sink,
+                           PositionBatchStats* stats, unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    threadCount = std::max(1u, threadCount);
+
+    const size_t window = 4 * size_t(threadCount);
+    std::vector<PositionBlock> completed(window);
+    std::vector<char> ready(window, 0);
+    const char* nextStart = first;
+    size_t nextIndex = 0;
+    size_t emitted = 0;
+    bool stopped = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    auto worker = [&]() {
+        while (true) {
+            size_t index;
+            const char* start;
+            const char* stop;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return stopped || nextStart == last || nextIndex < emitted + window; });
+                if (stopped || nextStart == last) return;
+                index = nextIndex++;
+                start = nextStart;
+                stop = size_t(last - start) <= POSITION_BLOCK_BYTES ? last : start + POSITION_BLOCK_BYTES;
+                stop = std::find(stop, last, '\n');
+                if (stop != last) stop++;
+                nextStart = stop;
+            }
+
+            PositionBlock block;
+            evaluatePositionBlock(start, stop, block);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            completed[index % window] = std::move(block);
+            ready[index % window] = 1;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; t++) {
+        workers.emplace_back(worker);
+    }
+
+    size_t lines = 0;
+    size_t badLine = 0;
+    PositionBatchStats totals;
+    for (size_t index = 0; ; index++) {
+        PositionBlock block;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return ready[index % window] != 0 || (nextStart == last && index == nextIndex); });
+            if (ready[index % window] == 0) break;
+            block = std::move(completed[index % window]);
+            ready[index % window] = 0;
+            emitted = index + 1;
+            if (block.badLine != 0) stopped = true;
+            changed.notify_all();
+        }
+
+        if (!block.sides.empty()) sink(block.sides.data(), block.sides.size());
+        totals.queries += block.sides.size();
+        totals.exact += block.exact;
+        if (block.badLine != 0) {
+            badLine = lines + block.badLine;
+            break;
+        }
+        lines += block.lines;
+    }
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (stats != nullptr) *stats = totals;
+    return badLine;
+}
+
+}
@@ -0,0 +1,138 @@
+#ifndef SEGMENT_CORE_H
+#define SEGMENT_CORE_H
+
+#include <functional>
+#include <vector>
+
+#include "geometry.h"
+#include "big_number.h"
+#include "decimal.h"
+
+namespace geom {
+
+// Band classified as "on the segment": within distance of its line while the
+// projection parameter stays in [-overhang, 1 + overhang].
+struct SideTolerance {
+    double distance;
+    double overhang;
+    SideTolerance(double distance = 5, double overhang = 0.1) : distance(distance), overhang(overhang) {}
+};
+
+// 1 left of a->b, -1 right, 0 within tolerance of the segment (10% overhang allowed).
+int pointSegmentSide(const IntPoint& a, const IntPoint& b, const IntPoint& p, double tolerance = 5);
+
+// pointSegmentSide for the points (xs[i], ys[i]), written to sides[i]. The band
+// test runs on doubles four points at a time with AVX2; the side sign is exact,
+// lanes too close to the line for the double filter are redone on int64.
+void pointSegmentSides(const IntPoint& a, const IntPoint& b,
+                       const int32_t* xs, const int32_t* ys, size_t count, int8_t* sides,
+                       const SideTolerance& tolerance = SideTolerance());
+
+// Side queries against a polyline. Only polylines whose vertices advance
+// strictly along the first->last direction are supported; build() rejects any
+// other. Vertex projections on that direction are sorted, so a query finds the
+// segment over its slab by binary search in O(log n).
+class PolylineSideIndex {
+public:
+    // False when the polyline has fewer than two vertices or is not monotone.
+    bool build(const std::vector<IntPoint>& polyline);
+    bool built() const { return !vertices.empty(); }
+
+    // Without a successful build() every side is 0.
+    int side(const IntPoint& p, const SideTolerance& tolerance = SideTolerance()) const;
+    // With AVX2 the slab search and the band test both run four points at a
+    // time, each lane against its own segment; results match side().
+    void sides(const int32_t* xs, const int32_t* ys, size_t count, int8_t* out,
+               const SideTolerance& tolerance = SideTolerance()) const;
+
+private:
+    size_t slab(const IntPoint& p) const;
+
+    std::vector<IntPoint> vertices;
+    std::vector<int64_t> projections;
+    IntPoint direction;
+};
+
+bool isPointOnSegment(const IntPoint& p, const IntPoint& s1, const IntPoint& s2);
+// Exact for coordinates in [-2^30, 2^30).
+bool doSegmentsIntersect(const IntPoint& p1, const IntPoint& q1, const IntPoint& p2, const IntPoint& q2);
+
+enum SegmentRelation { DISJOINT, CROSSING, OVERLAPPING };
+
+// Exact intersection on int64 cross products with int128 numerators, valid for
+// coordinates in [-2^30, 2^30). For overlaps the point is the lexicographically
+// smallest shared point.
+SegmentRelation exactSegmentIntersection(const IntPoint& p1, const IntPoint& p2,
+                                         const IntPoint& p3, const IntPoint& p4, RationalPoint& result);
+
+// Crossing point of two non-parallel segments rounded to the nearest grid point.
+bool segmentIntersectionPoint(const IntPoint& p1, const IntPoint& p2,
+                              const IntPoint& p3, const IntPoint& p4, IntPoint& result);
+
+// Structure-of-arrays view: segment i runs from (x1[i], y1[i]) to (x2[i], y2[i]).
+struct SegmentArrays {
+    const int32_t* x1;
+    const int32_t* y1;
+    const int32_t* x2;
+    const int32_t* y2;
+};
+
+// Tests segment i of first against segment i of second for every i < count and
+// sets bit i % 64 of mask[i / 64] when they intersect (same rule as
+// doSegmentsIntersect). Uses AVX2 when the CPU has it; collinear lanes are
+// resolved by the exact scalar test. The fast paths assume coordinates in
+// [-2^30, 2^30); pairs with any coordinate outside are checked on int128
+// instead, so every int32 input is exact. Returns the number of intersecting pairs.
+size_t segmentPairsIntersect(const SegmentArrays& first, const SegmentArrays& second,
+                             size_t count, uint64_t* mask);
+
+struct Segment {
+    IntPoint a, b;
+    Segment() {}
+    Segment(const IntPoint& a, const IntPoint& b) : a(a), b(b) {}
+};
+
+struct SegmentIntersection {
+    uint32_t first, second;
+    RationalPoint point;
+};
+
+// Bentley-Ottmann sweep reporting every intersecting pair (first < second) in
+// O((n + k) log n), with exact event ordering for coordinates in [-2^30, 2^30).
+// Touching segments intersect; overlapping collinear pairs are reported once,
+// at the start of the overlap.
+std::vector<SegmentIntersection> segmentIntersections(const std::vector<Segment>& segments);
+uint64_t countSegmentIntersections(const std::vector<Segment>& segments);
+// Same sweep, handing every pair to visit as it is found instead of storing it.
+void visitSegmentIntersections(const std::vector<Segment>& segments,
+                               const std::function<void(uint32_t first, uint32_t second,
+                                                        const RationalPoint& point)>& visit);
+
+// Exact side of (xp, yp) relative to the segment: 1, -1, or 0 when it lies on it.
+int exactPointPosition(const BigNumber& x1, const BigNumber& y1,
+                       const BigNumber& x2, const BigNumber& y2,
+                       const BigNumber& xp, const BigNumber& yp);
+// The same on decimals, scaled to their common number of fraction digits.
+int exactPointPosition(const Decimal& x1, const Decimal& y1,
+                       const Decimal& x2, const Decimal& y2,
+                       const Decimal& xp, const Decimal& yp);
+
+struct PositionBatchStats {
+    size_t queries = 0;
+    size_t exact = 0;
+};
+
+// exactPointPosition for every "x1 y1 x2 y2 xp yp" line of text (blank and
+// comment lines as in parseDecimalPoints), parsed and evaluated in blocks on
+// worker threads. A double filter with a forward error bound settles clear
+// signs; queries near the line or with coordinates that are not cheap doubles
+// go to Decimal arithmetic. Blocks of sides reach the sink in input order.
+// Returns 0, or the 1-based number of the first malformed line; sides before
+// that line have been delivered.
+size_t batchPointPositions(const char* first, const char* last,
+                           const std::function<void(const int8_t* sides, size_t count)>& sink,
+                           PositionBatchStats* stats = nullptr, unsigned threadCount = 0);
+
+}
+
+#endif
@@ -0,0 +1,208 @@
+#include "trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace geom {
+
+namespace trace_detail {
+std::atomic<bool> enabled(false);
+}
+
+namespace {
+
+const size_t RING_CAPACITY = 1 << 14;
+
+// Oldest events are overwritten once a thread records more than RING_CAPACITY.
+// The mutex is only contended while another thread exports or clears.
+struct TraceBuffer {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    size_t next = 0;
+    uint32_t thread = 0;
+
+    void push(const TraceEvent& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (events.size() < RING_CAPACITY) {
+            events.push_back(event);
+        } else {
+            events[next] = event;
+        }
+        next = (next + 1) % RING_CAPACITY;
+    }
+
+    // Copies the events oldest first.
+    void snapshot(std::vector<TraceEvent>& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t first = events.size() < RING_CAPACITY ? 0 : next;
+        for (size_t i = 0; i < events.size(); i++) {
+            out.push_back(events[(first + i) % events.size()]);
+        }
+    }
+};
+
+// Buffers outlive their threads so a trace can be exported after workers
+// exit; the registry itself is never destroyed.
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry* instance = new TraceRegistry();
+    return *instance;
+}
+
+thread_local TraceBuffer* localBuffer = nullptr;
+
+TraceBuffer& threadBuffer() {
+    if (!localBuffer) {
+        TraceRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.buffers.emplace_back(new TraceBuffer());
+        localBuffer = r.buffers.back().get();
+        localBuffer->thread = uint32_t(r.buffers.size());
+    }
+    return *localBuffer;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+const Clock::time_point& epoch() {
+    static const Clock::time_point start = Clock::now();
+    return start;
+}
+
+void appendEscaped(std::string& out, const char* text) {
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') out += '\\';
+        out += *c;
+    }
+}
+
+// GEOM_TRACE=<file> enables tracing for the whole run.
+class EnvironmentTrace {
+public:
+    EnvironmentTrace() {
+        const char* value = std::getenv("GEOM_TRACE");
+        if (value && *value) {
+            path = value;
+            epoch();
+            setTracingEnabled(true);
+        }
+    }
+
+    ~EnvironmentTrace() {
+        if (!path.empty() && !writeChromeTrace(path)) {
+            std::fprintf(stderr, "GEOM_TRACE: cannot write %s\n", path.c_str());
+        }
+    }
+
+private:
+    std::string path;
+};
+
+EnvironmentTrace environmentTrace;
+
+}
+
+namespace trace_detail {
+
+void recordScope(const char* name, uint64_t start) {
+    TraceEvent event;
+    event.name = name;
+    event.start = start;
+    event.duration = traceClock() - start;
+    event.value = 0;
+    event.phase = 'X';
+    TraceBuffer& buffer = threadBuffer();
+    event.thread = buffer.thread;
+    buffer.push(event);
+}
+
+void recordCounter(const char* name, int64_t value) {
+    TraceEvent event;
+    event.name = name;
+    event.start = traceClock();
+    event.duration = 0;
+    event.value = value;
+    event.phase = 'C';
+    TraceBuffer& buffer = threadBuffer();
+    event.thread = buffer.thread;
+    buffer.push(event);
+}
+
+}
+
+void setTracingEnabled(bool enabled) {
+    trace_detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t traceClock() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch()).count());
+}
+
+void threadTraceEvents(uint64_t since, std::vector<TraceEvent>& events) {
+    if (!localBuffer) return;
+
+    size_t first = events.size();
+    localBuffer->snapshot(events);
+    size_t kept = first;
+    for (size_t i = first; i < events.size(); i++) {
+        if (events[i].start >= since) events[kept++] = events[i];
+    }
+    events.resize(kept);
+}
+
+void clearTrace() {
+    TraceRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& buffer : r.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->next = 0;
+    }
+}
+
+std::string chromeTraceJson() {
+    std::vector<TraceEvent> events;
+    {
+        TraceRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& buffer : r.buffers) buffer->snapshot(events);
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    char number[96];
+    for (size_t i = 0; i < events.size(); i++) {
+        const TraceEvent& event = events[i];
+        json += i == 0 ? "\n{\"name\":\"" : ",\n{\"name\":\"";
+        appendEscaped(json, event.name);
+        // Timestamps are in microseconds.
+        std::snprintf(number, sizeof(number), "\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+                      event.phase, event.thread, double(event.start) / 1000);
+        json += number;
+        if (event.phase == 'X') {
+            std::snprintf(number, sizeof(number), ",\"dur\":%.3f}", double(event.duration) / 1000);
+        } else {
+            std::snprintf(number, sizeof(number), ",\"args\":{\"value\":%lld}}", (long long)event.value);
+        }
+        json += number;
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    std::string json = chromeTraceJson();
+    out.write(json.data(), std::streamsize(json.size()));
+    return bool(out);
+}
+
+}
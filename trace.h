@@ -0,0 +1,72 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace geom {
+
+// One entry of a per-thread ring buffer. Names must be string literals; they
+// are stored as pointers and only read back on export.
+struct TraceEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+    int64_t value;
+    uint32_t thread;
+    char phase;
+};
+
+namespace trace_detail {
+extern std::atomic<bool> enabled;
+void recordScope(const char* name, uint64_t start);
+void recordCounter(const char* name, int64_t value);
+}
+
+// Off by default; GEOM_TRACE=<file> turns it on at startup and writes a Chrome
+// trace there at exit. While off, scopes and counters cost one relaxed load.
+inline bool tracingEnabled() { return trace_detail::enabled.load(std::memory_order_relaxed); }
+void setTracingEnabled(bool enabled);
+
+// Nanoseconds since the first call in this process.
+uint64_t traceClock();
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name)
+        : name(name), active(tracingEnabled()), start(active ? traceClock() : 0) {}
+    ~TraceScope() { end(); }
+
+    // Closes the scope early, for phases that do not end at a brace.
+    void end() {
+        if (active) trace_detail::recordScope(name, start);
+        active = false;
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    bool active;
+    uint64_t start;
+};
+
+inline void traceCounter(const char* name, int64_t value) {
+    if (tracingEnabled()) trace_detail::recordCounter(name, value);
+}
+
+// Events of the calling thread recorded at or after since, oldest first.
+void threadTraceEvents(uint64_t since, std::vector<TraceEvent>& events);
+
+void clearTrace();
+// Trace-event JSON for chrome://tracing and Perfetto, every thread included.
+std::string chromeTraceJson();
+bool writeChromeTrace(const std::string& path);
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef TRACE_OVERLAY_H
+#define TRACE_OVERLAY_H
+
+#include <QPainter>
+#include <QString>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "trace.h"
+
+// Timing of the last computation, drawn in a widget's top-right corner. The
+// total is always measured; with tracing enabled the phases recorded on this
+// thread between begin() and end() are listed under it, repeated phases summed.
+class TraceOverlay {
+public:
+    void begin() {
+        since = geom::traceClock();
+        started = std::chrono::steady_clock::now();
+    }
+
+    void end() {
+        totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        lines.clear();
+        if (!geom::tracingEnabled()) return;
+
+        events.clear();
+        geom::threadTraceEvents(since, events);
+        for (const auto& event : events) {
+            Line* line = nullptr;
+            for (auto& existing : lines) {
+                if (std::strcmp(existing.name, event.name) == 0) line = &existing;
+            }
+            if (!line) {
+                lines.push_back({event.name, event.phase, 0, 0, 0});
+                line = &lines.back();
+            }
+            line->ms += double(event.duration) / 1e6;
+            line->value = event.value;
+            line->count++;
+        }
+    }
+
+    // Total of the last computation, or -1 before the first.
+    double elapsedMs() const { return totalMs; }
+
+    void paint(QPainter& painter, const QRect& area) const {
+        if (totalMs < 0) return;
+
+        painter.save();
+        painter.setPen(Qt::darkGray);
+        int y = area.top() + 20;
+        QRect row(area.right() - 310, y - 14, 300, 18);
+        painter.drawText(row, Qt::AlignRight, QString("Расчёт: %1 мс").arg(totalMs, 0, 'f', 2));
+        for (const auto& line : lines) {
+            row.translate(0, 18);
+            QString text = line.phase == 'C'
+                ? QString("%1: %2").arg(line.name).arg(line.value)
+                : QString("%1: %2 мс").arg(line.name).arg(line.ms, 0, 'f', 2);
+            if (line.phase == 'X' && line.count > 1) text += QString(" (x%1)").arg(line.count);
+            painter.drawText(row, Qt::AlignRight, text);
+        }
+        painter.restore();
+    }
+
+private:
+    struct Line {
+        const char* name;
+        char phase;
+        double ms;
+        int64_t value;
+        int count;
+    };
+
+    uint64_t since = 0;
+    std::chrono::steady_clock::time_point started;
+    double totalMs = -1;
+    std::vector<Line> lines;
+    std::vector<geom::TraceEvent> events;
+};
+
+#endif